@@ -25,26 +25,120 @@
 #include "wdt.h"
 #include "delay.h"
 #include "storage.h"
+#include "clocksource.h"
+#include <libopencm3/cm3/cortex.h>
+#include <libopencm3/cm3/nvic.h>
 #include <libopencm3/stm32/rcc.h>
 #include <libopencm3/stm32/gpio.h>
 #include <libopencm3/stm32/adc.h>
 #include <libopencm3/stm32/dma.h>
+#include <libopencm3/stm32/timer.h>
 
+#define ADC_RESCALE_TARGET_RANGE 3200
+// stick calibration is applied as value * coef >> ADC_RESCALE_SHIFT
+#define ADC_RESCALE_SHIFT        12
+// keeps value * coef within int32 for broken calibrations
+#define ADC_RESCALE_MIN_DIVIDER  64
+
+// internal channel -> adc data index for the detected hw revision
+typedef struct {
+    uint8_t index;
+    uint8_t invert;
+} adc_channel_map_t;
+
+// the gimbals are adc0..3 on all hw revisions
+#define ADC_STICK_COUNT          4
+#define ADC_BATTERY_CHANNEL      10
+
+// one entry of the conversion schedule. the f0 adc has a single sample
+// time for all channels, so each slot converts its own channel group
+typedef struct {
+    const uint8_t *channels;
+    uint8_t count;
+    uint8_t sample_time;
+} adc_slot_t;
+
+#define ADC_SLOT_STICKS          0
+#define ADC_SLOT_AUX             1
+#define ADC_SLOT_BATTERY         2
+
+// sequences are converted in ascending channel order
+static const uint8_t adc_slot_stick_channels[]   = { 0, 1, 2, 3 };
+static const uint8_t adc_slot_aux_channels[]     = { 4, 5, 6, 7, 8, 9 };
+static const uint8_t adc_slot_battery_channels[] = { ADC_BATTERY_CHANNEL };
+
+static const adc_slot_t adc_slot[] = {
+    // sticks only, short sample time for the low impedance gimbal pots
+    [ADC_SLOT_STICKS]  = { adc_slot_stick_channels, sizeof(adc_slot_stick_channels),
+                           ADC_SMPTIME_013DOT5 },
+    [ADC_SLOT_AUX]     = { adc_slot_aux_channels, sizeof(adc_slot_aux_channels),
+                           ADC_SMPTIME_041DOT5 },
+    // the battery divider has a high source impedance
+    [ADC_SLOT_BATTERY] = { adc_slot_battery_channels, sizeof(adc_slot_battery_channels),
+                           ADC_SMPTIME_239DOT5 },
+};
+
+// every stick sample uses the stick sample time and a stick frame
+// always spans five slots
+#define ADC_SCHEDULE_LENGTH      10
+static const uint8_t adc_schedule[ADC_SCHEDULE_LENGTH] = {
+    ADC_SLOT_STICKS, ADC_SLOT_STICKS, ADC_SLOT_STICKS, ADC_SLOT_STICKS, ADC_SLOT_AUX,
+    ADC_SLOT_STICKS, ADC_SLOT_STICKS, ADC_SLOT_STICKS, ADC_SLOT_STICKS, ADC_SLOT_BATTERY,
+};
+
+// the dma fills one buffer with the next slot while the isr reads the other
+static uint16_t adc_dma_buffer[2][ADC_CHANNEL_COUNT];
+static uint8_t  adc_dma_index;
+static uint8_t  adc_schedule_index;
+// slot the adc sequence and sample time are set up for
+static uint8_t  adc_armed_slot;
+// oversampling accumulators, only touched by the dma isr
+static uint32_t adc_sum[ADC_CHANNEL_COUNT];
+static uint8_t  adc_sum_count;
+static uint8_t  adc_aux_sum_count;
+static uint8_t  adc_battery_sum_count;
+// last complete averaged frame
 static uint16_t adc_data[ADC_CHANNEL_COUNT];
 static uint16_t adc_battery_voltage_raw_filtered;
+static adc_channel_map_t adc_channel_map[CHANNEL_ID_SIZE];
+
+// reciprocal stick coefficients ([0] below, [1] above center) and the
+// calibration and scale they were calculated from
+static int32_t  adc_rescale_coef[4][2];
+static uint16_t adc_rescale_calibration[4][3];
+static uint8_t  adc_rescale_scale;
+static uint8_t  adc_rescale_valid;
+
+// double buffered snapshot of all rescaled channels, readers always
+// see the buffer that was completed last
+static int16_t adc_rescaled[2][CHANNEL_ID_SIZE];
+static volatile uint8_t adc_rescaled_index;
 
 // internal functions
 static void adc_init_rcc(void);
 static void adc_init_gpio(void);
 static void adc_init_mode(void);
 static void adc_init_dma(void);
-static void adc_dma_arm(void);
+static void adc_init_timer(void);
+static void adc_init_channel_map(void);
+static void adc_slot_arm(uint8_t slot);
+static void adc_process_slot(uint8_t slot, uint16_t *sequence);
+static void adc_update_coefficients(void);
+static int32_t adc_rescale_coefficient(int32_t divider, int32_t scale);
+static int32_t adc_rescale_channel(uint8_t idx);
+static void adc_update_snapshot(void);
 
 void adc_init(void) {
     debug("adc: init\n"); debug_flush();
 
     adc_battery_voltage_raw_filtered = 0;
+    adc_sum_count = 0;
+    adc_aux_sum_count = 0;
+    adc_battery_sum_count = 0;
+    adc_rescale_valid = 0;
+    adc_rescaled_index = 0;
 
+    adc_init_channel_map();
     adc_init_rcc();
     adc_init_gpio();
     adc_init_mode();
@@ -54,44 +148,73 @@ void adc_init(void) {
     uint32_t i;
     for (i = 0; i < ADC_CHANNEL_COUNT; i++) {
         adc_data[i] = i;
+        adc_sum[i] = 0;
     }
+
+    // publish a first snapshot, the dma isr keeps it up to date
+    adc_update_snapshot();
+
+    // start the conversion timer
+    adc_init_timer();
 }
 
-uint16_t adc_get_channel(uint32_t id) {
-    // fetch correct adc channel based on hw revision
-    if (config_hw_revision == CONFIG_HW_REVISION_I6S) {
-        // FS-i6S mapping:
-        switch (id) {
-            default : return adc_data[id];
-            case (CHANNEL_ID_AILERON)  : return adc_data[0];
-            case (CHANNEL_ID_ELEVATION): return adc_data[1];
-            case (CHANNEL_ID_THROTTLE) : return adc_data[2];
-            case (CHANNEL_ID_RUDDER)   : return adc_data[3];
-            case (CHANNEL_ID_CH0)      : return adc_data[4];
-            case (CHANNEL_ID_CH1)      : return adc_data[5];
-            case (CHANNEL_ID_CH2)      : return adc_data[8];
-            case (CHANNEL_ID_CH3)      : return adc_data[9];
-        }
-    } else if (config_hw_revision == CONFIG_HW_REVISION_EVOLUTION) {
-        // TGY Evolution mapping:
-        switch (id) {
-            default : return adc_data[id];
-            case (CHANNEL_ID_AILERON)  : return 4095 - adc_data[3];
-            case (CHANNEL_ID_ELEVATION): return 4095 - adc_data[2];
-            case (CHANNEL_ID_THROTTLE) : return 4095 - adc_data[1];
-            case (CHANNEL_ID_RUDDER)   : return 4095 - adc_data[0];
-            case (CHANNEL_ID_CH0)      : return adc_data[5];
-            case (CHANNEL_ID_CH1)      : return adc_data[8];
-            case (CHANNEL_ID_CH2)      : return adc_data[6];
-            case (CHANNEL_ID_CH3)      : return adc_data[4];
+static void adc_init_channel_map(void) {
+    // FS-i6S mapping:
+    static const adc_channel_map_t map_i6s[CHANNEL_ID_SIZE] = {
+        [CHANNEL_ID_AILERON]   = { 0, 0 },
+        [CHANNEL_ID_ELEVATION] = { 1, 0 },
+        [CHANNEL_ID_THROTTLE]  = { 2, 0 },
+        [CHANNEL_ID_RUDDER]    = { 3, 0 },
+        [CHANNEL_ID_CH0]       = { 4, 0 },
+        [CHANNEL_ID_CH1]       = { 5, 0 },
+        [CHANNEL_ID_CH2]       = { 8, 0 },
+        [CHANNEL_ID_CH3]       = { 9, 0 },
+    };
+    // TGY Evolution mapping:
+    static const adc_channel_map_t map_evolution[CHANNEL_ID_SIZE] = {
+        [CHANNEL_ID_AILERON]   = { 3, 1 },
+        [CHANNEL_ID_ELEVATION] = { 2, 1 },
+        [CHANNEL_ID_THROTTLE]  = { 1, 1 },
+        [CHANNEL_ID_RUDDER]    = { 0, 1 },
+        [CHANNEL_ID_CH0]       = { 5, 0 },
+        [CHANNEL_ID_CH1]       = { 8, 0 },
+        [CHANNEL_ID_CH2]       = { 6, 0 },
+        [CHANNEL_ID_CH3]       = { 4, 0 },
+    };
+    uint32_t i;
+
+    // resolve the hw revision once instead of on every access
+    for (i = 0; i < CHANNEL_ID_SIZE; i++) {
+        if (config_hw_revision == CONFIG_HW_REVISION_I6S) {
+            adc_channel_map[i] = map_i6s[i];
+        } else if (config_hw_revision == CONFIG_HW_REVISION_EVOLUTION) {
+            adc_channel_map[i] = map_evolution[i];
+        } else {
+            adc_channel_map[i].index  = i;
+            adc_channel_map[i].invert = 0;
         }
     }
 
-    // else: undefined!
-    debug("adc: invalid hw revision ");
-    debug_put_uint8(config_hw_revision);
-    debug(" given!\n"); debug_flush();
-    return 0;
+    if ((config_hw_revision != CONFIG_HW_REVISION_I6S) &&
+        (config_hw_revision != CONFIG_HW_REVISION_EVOLUTION)) {
+        // undefined!
+        debug("adc: invalid hw revision ");
+        debug_put_uint8(config_hw_revision);
+        debug(" given!\n"); debug_flush();
+    }
+}
+
+uint16_t adc_get_channel(uint32_t id) {
+    if (id >= CHANNEL_ID_SIZE) {
+        return adc_data[id];
+    }
+
+    // fetch correct adc channel based on hw revision
+    adc_channel_map_t *map = &adc_channel_map[id];
+    if (map->invert) {
+        return 4095 - adc_data[map->index];
+    }
+    return adc_data[map->index];
 }
 
 char *adc_get_channel_name(uint8_t i, bool short_descr) {
@@ -109,54 +232,119 @@ char *adc_get_channel_name(uint8_t i, bool short_descr) {
 }
 
 
-#define ADC_RESCALE_TARGET_RANGE 3200
+static int32_t adc_rescale_coefficient(int32_t divider, int32_t scale) {
+    divider = max(divider, ADC_RESCALE_MIN_DIVIDER);
+
+    // TARGET_RANGE / divider * scale / 100 as a fixed point factor. this
+    // only runs when the calibration changes, so the division is fine
+    return ((ADC_RESCALE_TARGET_RANGE * scale) << ADC_RESCALE_SHIFT) / (100 * divider);
+}
+
+static void adc_update_coefficients(void) {
+    uint32_t i, j;
+    uint8_t changed = !adc_rescale_valid;
+    uint8_t stick_scale = storage.model[storage.current_model].stick_scale;
+
+    // cheap check if the calibration or the model scale changed
+    if (stick_scale != adc_rescale_scale) {
+        changed = 1;
+    }
+    for (i = 0; i < 4; i++) {
+        for (j = 0; j < 3; j++) {
+            if (storage.stick_calibration[i][j] != adc_rescale_calibration[i][j]) {
+                changed = 1;
+            }
+        }
+    }
+
+    if (!changed) {
+        return;
+    }
+
+    adc_rescale_scale = stick_scale;
+    for (i = 0; i < 4; i++) {
+        for (j = 0; j < 3; j++) {
+            adc_rescale_calibration[i][j] = storage.stick_calibration[i][j];
+        }
+
+        // the scale factor is only applied to aileron and elevation
+        int32_t scale = 100;
+        if ((i == CHANNEL_ID_AILERON) || (i == CHANNEL_ID_ELEVATION)) {
+            scale = stick_scale;
+        }
+
+        uint16_t *cal = adc_rescale_calibration[i];
+        adc_rescale_coef[i][0] = adc_rescale_coefficient((int32_t)cal[1] - cal[0], scale);
+        adc_rescale_coef[i][1] = adc_rescale_coefficient((int32_t)cal[2] - cal[1], scale);
+    }
+    adc_rescale_valid = 1;
+}
+
 // return the adc channel rescaled from 0...4095 to -TARGET_RANGE...+TARGET_RANGE
 // switches are scaled manually, sticks use calibration data
-int32_t adc_get_channel_rescaled(uint8_t idx) {
-    int32_t divider;
-
+static int32_t adc_rescale_channel(uint8_t idx) {
     // fetch raw stick value (0..4095)
     int32_t value = adc_get_channel(idx);
 
     // sticks are ch0..3 and use calibration coefficents:
     if (idx < 4) {
         // apply center calibration value:
-        value = value - (int16_t)storage.stick_calibration[idx][1];
+        value = value - (int16_t)adc_rescale_calibration[idx][1];
 
-        // now rescale this to +/- TARGET_RANGE
-        // fetch divider
+        // now rescale this to +/- TARGET_RANGE and apply the scale,
+        // round towards zero on both sides
         if (value < 0) {
-            divider = storage.stick_calibration[idx][1] - storage.stick_calibration[idx][0];
+            value = -((-value * adc_rescale_coef[idx][0]) >> ADC_RESCALE_SHIFT);
         } else {
-            divider = storage.stick_calibration[idx][2] - storage.stick_calibration[idx][1];
+            value = (value * adc_rescale_coef[idx][1]) >> ADC_RESCALE_SHIFT;
         }
-        // apply the scale
-        value = (value * ADC_RESCALE_TARGET_RANGE) / divider;
     } else {
         // for sticks we do not care about scaling/calibration (for now)
         // min is 0, max from adc is 4095 -> rescale this to +/- 3200
-        // rescale to 0...6400
-        value = (ADC_RESCALE_TARGET_RANGE * 2 * value) / 4096;
+        // rescale to 0...6400 (6400 / 4096 = 25 / 16)
+        value = (value * 25) >> 4;
         value = value - ADC_RESCALE_TARGET_RANGE;
     }
 
-    // apply the scale factor:
-    switch (idx) {
-        default:
-            // do not apply scale
-            break;
-        case (CHANNEL_ID_AILERON):
-        case (CHANNEL_ID_ELEVATION):
-            value = (value * storage.model[storage.current_model].stick_scale) / 100;
-            break;
-    }
-
     // limit value to -3200 ... 3200
     value = max(-ADC_RESCALE_TARGET_RANGE, min(ADC_RESCALE_TARGET_RANGE, value));
 
     return value;
 }
 
+static void adc_update_snapshot(void) {
+    uint32_t i;
+    uint8_t next = adc_rescaled_index ^ 1;
+
+    adc_update_coefficients();
+
+    for (i = 0; i < CHANNEL_ID_SIZE; i++) {
+        adc_rescaled[next][i] = adc_rescale_channel(i);
+    }
+
+    // publish
+    adc_rescaled_index = next;
+}
+
+int32_t adc_get_channel_rescaled(uint8_t idx) {
+    if (idx >= CHANNEL_ID_SIZE) {
+        return 0;
+    }
+    return adc_rescaled[adc_rescaled_index][idx];
+}
+
+// fetch all rescaled channels from the same snapshot
+void adc_get_channels_rescaled(int32_t *data) {
+    uint32_t i;
+
+    uint32_t primask = cm_mask_interrupts(1);
+    int16_t *snapshot = adc_rescaled[adc_rescaled_index];
+    for (i = 0; i < CHANNEL_ID_SIZE; i++) {
+        data[i] = snapshot[i];
+    }
+    cm_mask_interrupts(primask);
+}
+
 uint16_t adc_get_channel_packetdata(uint8_t idx) {
     // frsky packets send us * 1.5
     // where 1000 us =   0%
@@ -225,11 +413,11 @@ uint32_t adc_get_battery_voltage(void) {
 static void adc_init_mode(void) {
     debug("adc: init mode\n"); debug_flush();
 
-    // set mode to continous
-    adc_set_continuous_conversion_mode(ADC1);
+    // every trigger converts the whole sequence once
+    adc_set_single_conversion_mode(ADC1);
 
-    // no ext trigger
-    adc_disable_external_trigger_regular(ADC1);
+    // sequences are started by the conversion timer
+    adc_enable_external_trigger_regular(ADC1, ADC_TIMER_TRIGGER, ADC_CFGR1_EXTEN_RISING_EDGE);
     // right 12-bit data alignment in ADC reg
     adc_set_right_aligned(ADC1);
     adc_set_resolution(ADC1, ADC_RESOLUTION_12BIT);
@@ -237,13 +425,7 @@ static void adc_init_mode(void) {
     // adc_enable_temperature_sensor();
     adc_disable_analog_watchdog(ADC1);
 
-    // configure channels 0...10
-    uint8_t channels[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
-
-    // sample times for all channels
-    adc_set_sample_time_on_all_channels(ADC1, ADC_SMPTIME_041DOT5);
-
-    adc_set_regular_sequence(ADC1, sizeof(channels), channels);
+    // channels and sample time are set up per slot, see adc_slot_arm()
 
     adc_power_on(ADC1);
 
@@ -255,7 +437,7 @@ static void adc_init_mode(void) {
 
 
 
-    // enable DMA for ADC
+    // enable DMA for ADC in one shot mode, every slot re-arms it
     adc_enable_dma(ADC1);
 }
 
@@ -266,9 +448,8 @@ static void adc_init_dma(void) {
     // clean init
     dma_channel_reset(DMA1, ADC_DMA_CHANNEL);
 
-    // DO NOT use circular mode, we will retrigger dma on our own!
-    dma_enable_circular_mode(DMA1, ADC_DMA_CHANNEL);
-
+    // DO NOT use circular mode, every slot re-arms the dma with its own
+    // length and buffer
 
     // high priority
     dma_set_priority(DMA1, ADC_DMA_CHANNEL, DMA_CCR_PL_HIGH);
@@ -288,42 +469,132 @@ static void adc_init_dma(void) {
 
     // source and destination start addresses
     dma_set_peripheral_address(DMA1, ADC_DMA_CHANNEL, (uint32_t)&ADC1_DR);
-    dma_set_memory_address(DMA1, ADC_DMA_CHANNEL, (uint32_t)adc_data);
 
-    // chunk of data to be transfered
-    dma_set_number_of_data(DMA1, ADC_DMA_CHANNEL, ADC_CHANNEL_COUNT);
+    // transfer complete signals one finished slot
+    dma_enable_transfer_complete_interrupt(DMA1, ADC_DMA_CHANNEL);
+    nvic_set_priority(ADC_DMA_IRQ, NVIC_PRIO_ADC);
+    nvic_enable_irq(ADC_DMA_IRQ);
 
     // start conversion:
-    adc_dma_arm();
+    adc_dma_index = 0;
+    adc_schedule_index = 0;
+    adc_armed_slot = 0xFF;
+    adc_slot_arm(adc_schedule[0]);
 }
 
 
-static void adc_dma_arm(void) {
-    // start conversion
+static void adc_init_timer(void) {
+    debug("adc: init timer\n"); debug_flush();
+
+    rcc_periph_clock_enable(ADC_TIMER_CLOCK);
+    timer_reset(ADC_TIMER);
+
+    // 1MHz timer clock, one update event per sequence
+    timer_set_prescaler(ADC_TIMER, (rcc_timer_frequency / 1000000) - 1);
+    timer_set_mode(ADC_TIMER, TIM_CR1_CKD_CK_INT, TIM_CR1_CMS_EDGE, TIM_CR1_DIR_UP);
+    timer_set_period(ADC_TIMER, (1000000 / ADC_SEQUENCE_RATE_HZ) - 1);
+
+    // the update event is routed to the adc trigger
+    timer_set_master_mode(ADC_TIMER, TIM_CR2_MMS_UPDATE);
+
+    timer_enable_counter(ADC_TIMER);
+}
+
+static void adc_slot_arm(uint8_t slot) {
+    const adc_slot_t *next = &adc_slot[slot];
+
+    if (slot != adc_armed_slot) {
+        // sequence and sample time can only be changed while the adc is
+        // stopped. the last sequence is complete and the adc only waits
+        // for the next trigger, the stop takes a few adc clocks
+        if (ADC_CR(ADC1) & ADC_CR_ADSTART) {
+            ADC_CR(ADC1) |= ADC_CR_ADSTP;
+            while (ADC_CR(ADC1) & ADC_CR_ADSTP) {}
+        }
+        adc_set_regular_sequence(ADC1, next->count, (uint8_t *)next->channels);
+        adc_set_sample_time_on_all_channels(ADC1, next->sample_time);
+        adc_armed_slot = slot;
+    }
+
+    dma_disable_channel(DMA1, ADC_DMA_CHANNEL);
+    dma_set_memory_address(DMA1, ADC_DMA_CHANNEL, (uint32_t)adc_dma_buffer[adc_dma_index]);
+    dma_set_number_of_data(DMA1, ADC_DMA_CHANNEL, next->count);
     dma_enable_channel(DMA1, ADC_DMA_CHANNEL);
+
+    // start conversion, the adc now waits for the timer trigger
     adc_start_conversion_regular(ADC1);
 }
 
-void adc_process(void) {
-    // adc dma finished?
-    if (dma_get_interrupt_flag(DMA1, ADC_DMA_CHANNEL, ADC_DMA_TC_FLAG)) {
-        dma_clear_interrupt_flags(DMA1, ADC_DMA_CHANNEL, ADC_DMA_TC_FLAG);
+static void adc_process_slot(uint8_t slot, uint16_t *sequence) {
+    const adc_slot_t *done = &adc_slot[slot];
+    uint32_t i;
+
+    for (i = 0; i < done->count; i++) {
+        adc_sum[done->channels[i]] += sequence[i];
+    }
+
+    if (slot == ADC_SLOT_BATTERY) {
+        if (++adc_battery_sum_count < ADC_BATTERY_OVERSAMPLING) {
+            return;
+        }
+        uint16_t raw = adc_sum[ADC_BATTERY_CHANNEL] / ADC_BATTERY_OVERSAMPLING;
+        adc_sum[ADC_BATTERY_CHANNEL] = 0;
+        adc_battery_sum_count = 0;
+        adc_data[ADC_BATTERY_CHANNEL] = raw;
         if (adc_battery_voltage_raw_filtered == 0) {
             // initialise with current value
-            adc_battery_voltage_raw_filtered = adc_data[10];
+            adc_battery_voltage_raw_filtered = raw;
         } else {
             // low pass filter battery voltage
             adc_battery_voltage_raw_filtered = adc_battery_voltage_raw_filtered +
-                                     (4 * (adc_data[10] - adc_battery_voltage_raw_filtered)) / 128;
+                                     (4 * (raw - adc_battery_voltage_raw_filtered)) / 128;
         }
+        return;
+    }
 
-        // fine, arm DMA again:
-        adc_dma_arm();
-    } else {
-        // oops this should not happen
-        debug_putc('D');
-        // cancel and re arm dma ???
+    if (slot == ADC_SLOT_AUX) {
+        if (++adc_aux_sum_count >= ADC_AUX_OVERSAMPLING) {
+            // publish pots and switches
+            for (i = ADC_STICK_COUNT; i < ADC_BATTERY_CHANNEL; i++) {
+                adc_data[i] = adc_sum[i] / ADC_AUX_OVERSAMPLING;
+                adc_sum[i] = 0;
+            }
+            adc_aux_sum_count = 0;
+        }
+        return;
     }
+
+    if (++adc_sum_count < ADC_OVERSAMPLING) {
+        return;
+    }
+
+    // publish the averaged sticks
+    for (i = 0; i < ADC_STICK_COUNT; i++) {
+        adc_data[i] = adc_sum[i] / ADC_OVERSAMPLING;
+        adc_sum[i] = 0;
+    }
+    adc_sum_count = 0;
+
+    // rescale all channels once for every consumer
+    adc_update_snapshot();
+}
+
+void DMA1_Channel1_IRQHandler(void) {
+    if (!dma_get_interrupt_flag(DMA1, ADC_DMA_CHANNEL, DMA_TCIF)) {
+        return;
+    }
+    dma_clear_interrupt_flags(DMA1, ADC_DMA_CHANNEL, DMA_TCIF);
+
+    uint8_t done_slot = adc_schedule[adc_schedule_index];
+    uint16_t *done = adc_dma_buffer[adc_dma_index];
+
+    // arm the next slot right away, the dma fills the other buffer
+    // while this one is processed
+    adc_schedule_index = (adc_schedule_index + 1) % ADC_SCHEDULE_LENGTH;
+    adc_dma_index ^= 1;
+    adc_slot_arm(adc_schedule[adc_schedule_index]);
+
+    adc_process_slot(done_slot, done);
 }
 
 void adc_test(void) {
@@ -333,7 +604,6 @@ void adc_test(void) {
         debug_put_fixed2(adc_get_battery_voltage());
         debug(" V\n");
         uint32_t i;
-        adc_process();
         for (i = 0; i < ADC_CHANNEL_COUNT; i++) {
             debug_put_uint8(i+0); debug_putc('=');
             debug_put_hex16(adc_get_channel(i+0));
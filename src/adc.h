@@ -26,10 +26,10 @@
 void adc_init(void);
 void adc_test(void);
 
-void adc_process(void);
 
 uint16_t adc_get_channel(uint32_t id);
 int32_t  adc_get_channel_rescaled(uint8_t idx);
+void     adc_get_channels_rescaled(int32_t *data);
 uint16_t adc_get_channel_packetdata(uint8_t idx);
 uint32_t adc_get_battery_voltage(void);
 
@@ -56,5 +56,16 @@ char *adc_get_channel_name(uint8_t i, bool short_descr);
 #define ADC_RESCALED_ZERO_THRESHOLD      (ADC_RESCALED_ABSOLUTE_MIN + 0.1 * \
                                          (ADC_RESCALED_ABSOLUTE_MAX - ADC_RESCALED_ABSOLUTE_MIN))
 
+// the timer triggers one slot of the conversion schedule at this rate.
+// four of five slots convert the sticks, the fifth one alternates
+// between pots/switches and the battery
+#define ADC_SEQUENCE_RATE_HZ             5000
+// stick slots averaged per published stick frame (1kHz)
+#define ADC_OVERSAMPLING                 4
+// aux slots averaged per pot/switch update
+#define ADC_AUX_OVERSAMPLING             4
+// battery slots averaged per battery sample
+#define ADC_BATTERY_OVERSAMPLING         16
+
 
 #endif  // ADC_H_
@@ -19,9 +19,14 @@
 
 #include "cc2500.h"
 #include "spi.h"
+#include "register_image.h"
+#include "packet_pool.h"
 
 #include <libopencm3/stm32/rcc.h>
 #include <libopencm3/stm32/gpio.h>
+#include <libopencm3/stm32/exti.h>
+#include <libopencm3/cm3/nvic.h>
+#include <libopencm3/cm3/cortex.h>
 
 #include "debug.h"
 #include "timeout.h"
@@ -29,7 +34,58 @@
 
 // internal functions
 static void cc2500_init_gpio(void);
-
+static void cc2500_init_isr(void);
+static void cc2500_rx_start_dma(void);
+static void cc2500_rx_dma_done(uint32_t result);
+static void cc2500_shadow_invalidate(void);
+static void cc2500_discard_fifo(uint8_t len);
+static uint8_t cc2500_shadow_cacheable(uint8_t address);
+static uint8_t cc2500_shadow_hit(uint8_t address, uint8_t data);
+static void cc2500_shadow_store(uint8_t address, uint8_t data);
+static void cc2500_shadow_forget(uint8_t address);
+static void cc2500_shadow_mark_dirty(const spi_transaction_t *chain, uint8_t count);
+static uint32_t cc2500_xfer_chain(spi_transaction_t *chain, uint8_t count);
+static void cc2500_xfer_chain_done(uint32_t result);
+static spi_transaction_t *cc2500_chain_append(cc2500_chain_t *chain, uint8_t header, uint8_t len);
+static void cc2500_path_tx_lna_off(void);
+static void cc2500_path_tx_pa_on(void);
+static void cc2500_path_rx_lna_on(void);
+static void cc2500_path_rx_pa_off(void);
+
+// packet events are driven by the gdo2 sync / end of packet interrupt
+static volatile uint8_t cc2500_tx_active;
+static packet_buffer_t *cc2500_rx_packet;
+static uint8_t cc2500_rx_len;
+static cc2500_packet_callback_t cc2500_packet_callback;
+static spi_transaction_t cc2500_rx_chain[3];
+// fifo level and frequency offset estimate, read together with each dma packet
+static uint8_t cc2500_rx_bytes;
+static uint8_t cc2500_rx_freqest;
+
+// number of register runs queued at once by the image loader
+#define CC2500_REGISTER_IMAGE_CHAIN_SIZE 8
+// attempts to queue a blocking chain while the isrs fill the spi queue
+#define CC2500_XFER_RETRY 3
+static volatile uint32_t cc2500_xfer_result;
+
+
+// write-through shadow of the config registers, unchanged values are
+// not sent again. bit n of valid/dirty refers to register n
+#define CC2500_SHADOW_SIZE       (TEST0 + 1)
+#define CC2500_SHADOW_FLAGS_SIZE ((CC2500_SHADOW_SIZE + 7) / 8)
+// clean registers in between dirty ones are resent if this merges bursts
+#define CC2500_SHADOW_MERGE_GAP  2
+static uint8_t cc2500_shadow[CC2500_SHADOW_SIZE];
+static uint8_t cc2500_shadow_valid[CC2500_SHADOW_FLAGS_SIZE];
+static uint8_t cc2500_shadow_dirty[CC2500_SHADOW_FLAGS_SIZE];
+#define CC2500_SHADOW_FLAG_GET(_f, _a) ((_f)[(_a) >> 3] & (1 << ((_a) & 7)))
+#define CC2500_SHADOW_FLAG_SET(_f, _a) { (_f)[(_a) >> 3] |= (1 << ((_a) & 7)); }
+#define CC2500_SHADOW_FLAG_CLR(_f, _a) { (_f)[(_a) >> 3] &= ~(1 << ((_a) & 7)); }
+
+// spi bytes not sent thanks to the shadow
+static volatile uint32_t cc2500_shadow_saved;
+static uint32_t cc2500_shadow_rate_ms;
+static uint32_t cc2500_shadow_rate_saved;
 
 #define CC2500_DEBUG_STATUSBYTE 0
 
@@ -37,6 +93,22 @@ void cc2500_init(void) {
     debug("cc2500: init\n"); debug_flush();
     cc2500_init_gpio();
     spi_init();
+    cc2500_init_isr();
+
+    // the register content is unknown
+    cc2500_shadow_invalidate();
+    cc2500_shadow_saved = 0;
+    cc2500_shadow_rate_ms = timeout_get_ms();
+    cc2500_shadow_rate_saved = 0;
+}
+
+// called when there is no cc2500 on the rf pads: gdo2 of the module
+// fitted instead must not trigger our isr, the bus is handed over
+void cc2500_release(void) {
+    exti_disable_request(CC2500_GDO2_EXTI_SOURCE_LINE);
+    nvic_disable_irq(CC2500_GDO2_EXTI_IRQN);
+    cc2500_set_packet_callback(0, 0);
+    spi_release();
 }
 
 static void cc2500_init_gpio(void) {
@@ -78,7 +150,112 @@ static void cc2500_init_gpio(void) {
     gpio_set_output_options(CC2500_GDO2_GPIO, GPIO_OTYPE_PP, GPIO_OSPEED_50MHZ, CC2500_GDO2_PIN);
 }
 
-inline void cc2500_enter_rxmode(void) {
+static void cc2500_init_isr(void) {
+    // interrupt on both edges of gdo2 (sync word and end of packet)
+
+    // clock for syscfg
+    rcc_periph_clock_enable(RCC_SYSCFG_COMP);
+
+    // connect EXTI2 Line to gdo2
+    exti_select_source(CC2500_GDO2_EXTI_SOURCE_LINE, CC2500_GDO2_EXTI_SOURCE);
+    exti_set_trigger(CC2500_GDO2_EXTI_SOURCE_LINE, EXTI_TRIGGER_BOTH);
+    exti_enable_request(CC2500_GDO2_EXTI_SOURCE_LINE);
+
+    // enable irq
+    nvic_enable_irq(CC2500_GDO2_EXTI_IRQN);
+    nvic_set_priority(CC2500_GDO2_EXTI_IRQN, NVIC_PRIO_FRSKY);
+}
+
+void cc2500_set_packet_callback(cc2500_packet_callback_t callback, uint8_t rx_len) {
+    // packets are read by dma straight into a pool buffer,
+    // only packets with exactly rx_len bytes are accepted
+    cc2500_rx_len          = rx_len;
+    cc2500_packet_callback = callback;
+}
+
+void EXTI2_3_IRQHandler(void) {
+    if (exti_get_flag_status(CC2500_GDO2_EXTI_SOURCE_LINE) != 0) {
+        exti_reset_request(CC2500_GDO2_EXTI_SOURCE_LINE);
+
+        if (gpio_get(CC2500_GDO2_GPIO, CC2500_GDO2_PIN)) {
+            // rising edge: sync word sent or received
+            if (cc2500_packet_callback) cc2500_packet_callback(CC2500_EVENT_SYNC, 0);
+        } else if (cc2500_tx_active) {
+            // falling edge during tx: packet is out
+            if (cc2500_packet_callback) cc2500_packet_callback(CC2500_EVENT_TX_DONE, 0);
+        } else {
+            // falling edge during rx: end of packet
+            cc2500_rx_start_dma();
+        }
+    }
+}
+
+static void cc2500_rx_start_dma(void) {
+    if ((cc2500_packet_callback == 0) || (cc2500_rx_len == 0)) {
+        return;
+    }
+
+    cc2500_rx_packet = packet_pool_alloc(PACKET_OWNER_DMA);
+    if (!cc2500_rx_packet) {
+        // no buffer left, drop this packet
+        cc2500_packet_callback(CC2500_EVENT_RX_ERROR, 0);
+        return;
+    }
+    cc2500_rx_packet->len = cc2500_rx_len;
+
+    // the rxbytes errata only affects reads during reception,
+    // after the end of packet the fifo level is stable. it is checked
+    // once the chain is done, a short fifo is flushed before the next rx
+    cc2500_rx_chain[0].header  = RXBYTES | READ_FLAG;
+    cc2500_rx_chain[0].len     = 1;
+    cc2500_rx_chain[0].tx_data = 0;
+    cc2500_rx_chain[0].rx_data = &cc2500_rx_bytes;
+    cc2500_rx_chain[0].action  = 0;
+
+    // read the fifo straight into the packet buffer
+    cc2500_rx_chain[1].header  = CC2500_FIFO | READ_FLAG | BURST_FLAG;
+    cc2500_rx_chain[1].len     = cc2500_rx_len;
+    cc2500_rx_chain[1].tx_data = 0;
+    cc2500_rx_chain[1].rx_data = cc2500_rx_packet->data;
+    cc2500_rx_chain[1].action  = 0;
+
+    // FREQEST is valid until the next packet, grab it in the same chain
+    cc2500_rx_chain[2].header  = FREQEST | READ_FLAG;
+    cc2500_rx_chain[2].len     = 1;
+    cc2500_rx_chain[2].tx_data = 0;
+    cc2500_rx_chain[2].rx_data = &cc2500_rx_freqest;
+    cc2500_rx_chain[2].action  = 0;
+
+    if (!spi_xfer_async(cc2500_rx_chain, 3, cc2500_rx_dma_done)) {
+        // spi queue full
+        cc2500_rx_dma_done(SPI_XFER_TIMEOUT);
+    }
+}
+
+int8_t cc2500_get_rx_freq_estimate(void) {
+    // offset of the last dma packet, in FSCTRL0 steps (two's complement)
+    return (int8_t)cc2500_rx_freqest;
+}
+
+static void cc2500_rx_dma_done(uint32_t result) {
+    packet_buffer_t *packet = cc2500_rx_packet;
+    cc2500_rx_packet = 0;
+
+    if ((result != SPI_XFER_OK) || (cc2500_rx_bytes != cc2500_rx_len)) {
+        // overflow or unexpected length, leave it to the caller to flush
+        packet_pool_free(packet);
+        cc2500_packet_callback(CC2500_EVENT_RX_ERROR, 0);
+        return;
+    }
+
+    // the decoder owns the packet now and has to free it
+    packet_pool_handoff(packet, PACKET_OWNER_DECODER);
+    cc2500_packet_callback(CC2500_EVENT_RX_DONE, packet);
+}
+
+void cc2500_enter_rxmode(void) {
+    cc2500_tx_active = 0;
+
     // LNA = 1, PA = 0
     gpio_set(CC2500_LNA_GPIO, CC2500_LNA_PIN);  // 1
     delay_us(20);
@@ -102,34 +279,248 @@ inline uint32_t cc2500_set_antenna(uint8_t id) {
 
 inline void cc2500_set_gdo_mode(void) {
     // set to RX FIFO signal
-    cc2500_set_register(IOCFG0, 0x01);
-    // cc2500_set_register(IOCFG1, 0x02); //
-    cc2500_set_register(IOCFG2, 0x02);
+    cc2500_queue_register(IOCFG0, 0x01);
+    // cc2500_queue_register(IOCFG1, 0x02); //
+    // gdo2: asserts on sync word, deasserts at end of packet (rx and tx)
+    cc2500_queue_register(IOCFG2, 0x06);
+    cc2500_flush_registers();
 }
 
-inline void cc2500_set_register(uint8_t address, uint8_t data) {
+uint32_t cc2500_select(void) {
+    // never interfere with a transaction chain, the isrs queue
+    // theirs until cc2500_deselect() releases the bus
+    spi_bus_lock();
+
     // select device
     cc2500_csn_lo();
 
-
     // wait for ready signal
-    while (gpio_get(CC2500_SPI_GPIO, CC2500_SPI_MISO_PIN) == 1) {}
+    if (!spi_wait_miso_ready()) {
+        // chip did not respond
+        cc2500_deselect();
+        return 0;
+    }
+    return 1;
+}
+
+void cc2500_deselect(void) {
+    cc2500_csn_hi();
+    spi_bus_unlock();
+}
+
+inline void cc2500_set_register(uint8_t address, uint8_t data) {
+    if (cc2500_shadow_hit(address, data)) {
+        // already set, skip address and data byte
+        return;
+    }
+
+    // select device
+    if (!cc2500_select()) return;
 
     spi_tx(address);
     spi_tx(data);
 
-    // deslect
-    cc2500_csn_hi();
+    // deselect
+    cc2500_deselect();
+
+    cc2500_shadow_store(address, data);
+}
+
+void cc2500_queue_register(uint8_t address, uint8_t data) {
+    if (!cc2500_shadow_cacheable(address)) {
+        // can not be batched
+        cc2500_set_register(address, data);
+        return;
+    }
+
+    uint32_t primask = cm_mask_interrupts(1);
+    if (CC2500_SHADOW_FLAG_GET(cc2500_shadow_valid, address) && (cc2500_shadow[address] == data)) {
+        // nothing to do
+        if (!CC2500_SHADOW_FLAG_GET(cc2500_shadow_dirty, address)) {
+            cc2500_shadow_saved += 2;
+        }
+    } else {
+        cc2500_shadow[address] = data;
+        CC2500_SHADOW_FLAG_SET(cc2500_shadow_valid, address);
+        CC2500_SHADOW_FLAG_SET(cc2500_shadow_dirty, address);
+    }
+    cm_mask_interrupts(primask);
+}
+
+void cc2500_flush_registers(void) {
+    spi_transaction_t chain[CC2500_REGISTER_IMAGE_CHAIN_SIZE];
+    uint8_t count = 0;
+    uint8_t address = 0;
+    // what the bursts saved against single writes of 2 bytes each
+    uint32_t single = 0;
+    uint32_t sent = 0;
+
+    while (address < CC2500_SHADOW_SIZE) {
+        if (!CC2500_SHADOW_FLAG_GET(cc2500_shadow_dirty, address)) {
+            address++;
+            continue;
+        }
+
+        // extend the burst over dirty registers and short gaps of valid ones,
+        // the slot isr updates the same bitmaps
+        uint8_t start = address;
+        uint8_t end   = address;
+        uint8_t next;
+        uint32_t primask = cm_mask_interrupts(1);
+        for (next = address + 1; next < CC2500_SHADOW_SIZE; next++) {
+            if (!CC2500_SHADOW_FLAG_GET(cc2500_shadow_valid, next) ||
+                !cc2500_shadow_cacheable(next) ||
+                (next - end > CC2500_SHADOW_MERGE_GAP)) {
+                break;
+            }
+            if (CC2500_SHADOW_FLAG_GET(cc2500_shadow_dirty, next)) {
+                end = next;
+            }
+        }
+
+        for (next = start; next <= end; next++) {
+            if (CC2500_SHADOW_FLAG_GET(cc2500_shadow_dirty, next)) {
+                CC2500_SHADOW_FLAG_CLR(cc2500_shadow_dirty, next);
+                single += 2;
+            }
+        }
+        cm_mask_interrupts(primask);
+        sent += 1 + end - start + 1;
+
+        chain[count].header  = start | BURST_FLAG;
+        chain[count].len     = end - start + 1;
+        chain[count].tx_data = &cc2500_shadow[start];
+        chain[count].rx_data = 0;
+        chain[count].action  = 0;
+        count++;
+
+        address = end + 1;
+
+        if (count == CC2500_REGISTER_IMAGE_CHAIN_SIZE) {
+            if (!cc2500_xfer_chain(chain, count)) {
+                // keep them dirty, the next flush sends them again
+                cc2500_shadow_mark_dirty(chain, count);
+                return;
+            }
+            count = 0;
+        }
+    }
+
+    if (count && !cc2500_xfer_chain(chain, count)) {
+        cc2500_shadow_mark_dirty(chain, count);
+        return;
+    }
+
+    if (single > sent) {
+        uint32_t primask = cm_mask_interrupts(1);
+        cc2500_shadow_saved += single - sent;
+        cm_mask_interrupts(primask);
+    }
+}
+
+uint32_t cc2500_get_spi_bytes_saved(void) {
+    return cc2500_shadow_saved;
+}
+
+// average over the time since the last call
+uint32_t cc2500_get_spi_bytes_saved_per_second(void) {
+    uint32_t now     = timeout_get_ms();
+    uint32_t saved   = cc2500_shadow_saved;
+    uint32_t elapsed = now - cc2500_shadow_rate_ms;
+    uint32_t rate    = 0;
+
+    if (elapsed) {
+        rate = ((saved - cc2500_shadow_rate_saved) * 1000) / elapsed;
+    }
+
+    cc2500_shadow_rate_ms    = now;
+    cc2500_shadow_rate_saved = saved;
+    return rate;
+}
+
+static uint8_t cc2500_shadow_cacheable(uint8_t address) {
+    if (address >= CC2500_SHADOW_SIZE) {
+        // status registers, pa table and fifo
+        return 0;
+    }
+    // the frequency synthesizer calibration is updated by the chip
+    if ((address >= FSCAL3) && (address <= FSCAL1)) {
+        return 0;
+    }
+    return 1;
+}
+
+// test for an unchanged value and count the saved bytes
+static uint8_t cc2500_shadow_hit(uint8_t address, uint8_t data) {
+    uint8_t hit = 0;
+
+    if (!cc2500_shadow_cacheable(address)) {
+        return 0;
+    }
+
+    uint32_t primask = cm_mask_interrupts(1);
+    if (CC2500_SHADOW_FLAG_GET(cc2500_shadow_valid, address) &&
+        !CC2500_SHADOW_FLAG_GET(cc2500_shadow_dirty, address) &&
+        (cc2500_shadow[address] == data)) {
+        cc2500_shadow_saved += 2;
+        hit = 1;
+    }
+    cm_mask_interrupts(primask);
+
+    return hit;
+}
+
+static void cc2500_shadow_store(uint8_t address, uint8_t data) {
+    if (!cc2500_shadow_cacheable(address)) {
+        return;
+    }
+    uint32_t primask = cm_mask_interrupts(1);
+    cc2500_shadow[address] = data;
+    CC2500_SHADOW_FLAG_SET(cc2500_shadow_valid, address);
+    CC2500_SHADOW_FLAG_CLR(cc2500_shadow_dirty, address);
+    cm_mask_interrupts(primask);
+}
+
+static void cc2500_shadow_forget(uint8_t address) {
+    if (!cc2500_shadow_cacheable(address)) {
+        return;
+    }
+    uint32_t primask = cm_mask_interrupts(1);
+    CC2500_SHADOW_FLAG_CLR(cc2500_shadow_valid, address);
+    CC2500_SHADOW_FLAG_CLR(cc2500_shadow_dirty, address);
+    cm_mask_interrupts(primask);
+}
+
+// the burst writes of a chain did not reach the chip, the next
+// cc2500_flush_registers() sends these registers again
+static void cc2500_shadow_mark_dirty(const spi_transaction_t *chain, uint8_t count) {
+    uint32_t i, address;
+
+    uint32_t primask = cm_mask_interrupts(1);
+    for (i = 0; i < count; i++) {
+        uint8_t start = chain[i].header & ~(READ_FLAG | BURST_FLAG);
+        for (address = start; address < (uint32_t)start + chain[i].len; address++) {
+            if (cc2500_shadow_cacheable(address)) {
+                CC2500_SHADOW_FLAG_SET(cc2500_shadow_valid, address);
+                CC2500_SHADOW_FLAG_SET(cc2500_shadow_dirty, address);
+            }
+        }
+    }
+    cm_mask_interrupts(primask);
+}
+
+static void cc2500_shadow_invalidate(void) {
+    uint32_t primask = cm_mask_interrupts(1);
+    memset(cc2500_shadow_valid, 0, sizeof(cc2500_shadow_valid));
+    memset(cc2500_shadow_dirty, 0, sizeof(cc2500_shadow_dirty));
+    cm_mask_interrupts(primask);
 }
 
 inline uint8_t cc2500_get_register(uint8_t address) {
     uint8_t result;
 
     // select device:
-    cc2500_csn_lo();
-
-    // wait for RDY signal:
-    while (gpio_get(CC2500_SPI_GPIO, CC2500_SPI_MISO_PIN) == 1) {}
+    if (!cc2500_select()) return 0;
 
     // request address(read request has bit7 set)
     #if CC2500_DEBUG_STATUSBYTE
@@ -145,13 +536,19 @@ inline uint8_t cc2500_get_register(uint8_t address) {
     result = spi_rx();
 
     // deselect device
-    cc2500_csn_hi();
+    cc2500_deselect();
 
     // return result
     return(result);
 }
 
 inline void cc2500_strobe(uint8_t address) {
+    if (address == RFST_SRES) {
+        // back to reset values
+        cc2500_shadow_invalidate();
+    }
+
+    spi_bus_lock();
     cc2500_csn_lo();
 
     #if CC2500_DEBUG_STATUSBYTE
@@ -164,10 +561,11 @@ inline void cc2500_strobe(uint8_t address) {
     #endif  // CC2500_DEBUG_STATUSBYTE
 
     // debug("s"); debug_put_hex8(status); debug_put_newline();
-    cc2500_csn_hi();
+    cc2500_deselect();
 }
 
 inline uint8_t cc2500_get_status(void) {
+    spi_bus_lock();
     cc2500_csn_lo();
     uint8_t status = spi_tx(0xFF);
 
@@ -177,7 +575,7 @@ inline uint8_t cc2500_get_status(void) {
         debug_put_newline();
     #endif  // CC2500_DEBUG_STATUSBYT
 
-    cc2500_csn_hi();
+    cc2500_deselect();
     return status;
 }
 
@@ -188,7 +586,9 @@ uint8_t cc2500_transmission_completed(void) {
 
 
 
-inline void cc2500_enter_txmode(void) {
+void cc2500_enter_txmode(void) {
+    cc2500_tx_active = 1;
+
     // LNA = 0, PA = 1
     gpio_clear(CC2500_LNA_GPIO, CC2500_LNA_PIN);  // 0
     delay_us(20);
@@ -211,16 +611,43 @@ inline uint8_t cc2500_get_gdo_status(void) {
     }
 }
 
+static void cc2500_discard_fifo(uint8_t len) {
+    // a transaction without rx buffer throws away what is read
+    spi_transaction_t transaction;
+    transaction.header  = CC2500_FIFO | READ_FLAG | BURST_FLAG;
+    transaction.len     = len;
+    transaction.tx_data = 0;
+    transaction.rx_data = 0;
+    transaction.action  = 0;
+
+    if (!cc2500_xfer_chain(&transaction, 1)) {
+        debug("cc2500: fifo discard failed\n");
+    }
+}
+
+// pll calibration result of the current channel, FSCAL3 first
+void cc2500_fscal_save(uint8_t *fscal) {
+    uint32_t i;
+    for (i = 0; i < CC2500_FSCAL_COUNT; i++) {
+        fscal[i] = cc2500_get_register(FSCAL3 + i);
+    }
+}
+
+// main loop only, the isr path uses cc2500_chain_burst()
+void cc2500_fscal_load(const uint8_t *fscal) {
+    uint32_t i;
+    for (i = 0; i < CC2500_FSCAL_COUNT; i++) {
+        cc2500_set_register(FSCAL3 + i, fscal[i]);
+    }
+}
+
 inline void cc2500_read_fifo(uint8_t *buf, uint8_t len) {
     cc2500_register_read_multi(CC2500_FIFO | READ_FLAG | BURST_FLAG, buf, len);
 }
 
 inline void cc2500_register_read_multi(uint8_t address, uint8_t *buffer, uint8_t len) {
     // select device:
-    cc2500_csn_lo();
-
-    // wait for ready signal
-    while (gpio_get(CC2500_SPI_GPIO, CC2500_SPI_MISO_PIN) == 1) {}
+    if (!cc2500_select()) return;
 
     // debug("read "); debug_put_uint8(len); debug_flush();
     // request address(read request)
@@ -244,16 +671,13 @@ inline void cc2500_register_read_multi(uint8_t address, uint8_t *buffer, uint8_t
     }*/
 
     // deselect device
-    cc2500_csn_hi();
+    cc2500_deselect();
 }
 
 
 inline void cc2500_register_write_multi(uint8_t address, uint8_t *buffer, uint8_t len) {
     // select device:
-    cc2500_csn_lo();
-
-    // wait for RDY signal:
-    while (gpio_get(CC2500_SPI_GPIO, CC2500_SPI_MISO_PIN)) {}
+    if (!cc2500_select()) return;
 
     // request address(write request)
     spi_tx(address | BURST_FLAG);
@@ -262,7 +686,7 @@ inline void cc2500_register_write_multi(uint8_t address, uint8_t *buffer, uint8_
     spi_dma_xfer(buffer, len);
 
     // deselect device
-    cc2500_csn_hi();
+    cc2500_deselect();
 }
 
 inline void cc2500_process_packet(volatile uint8_t *packet_received, volatile uint8_t *buffer, \
@@ -289,16 +713,13 @@ inline void cc2500_process_packet(volatile uint8_t *packet_received, volatile ui
         if (len1 == len2) {
             len = len1;
 
-            // packet received, grab data
-            uint8_t tmp_buffer[len];
-            cc2500_read_fifo(tmp_buffer, len);
-
-            // only accept valid packet lengths:
             if (len == maxlen) {
-                for (i = 0; i < maxlen; i++) {
-                    buffer[i] = tmp_buffer[i];
-                }
+                // packet received, read it straight into the callers buffer
+                cc2500_read_fifo((uint8_t *)buffer, len);
                 *packet_received = 1;
+            } else {
+                // invalid packet length, drain the fifo
+                cc2500_discard_fifo(len);
             }
         } else {
             // no, ignore this
@@ -316,6 +737,193 @@ void cc2500_transmit_packet(volatile uint8_t *buffer, uint8_t len) {
     cc2500_strobe(RFST_STX);
 }
 
+void cc2500_write_register_image(const uint8_t *image) {
+    spi_transaction_t chain[CC2500_REGISTER_IMAGE_CHAIN_SIZE];
+    uint8_t count = 0;
+
+    while (REGISTER_IMAGE_RUN_LENGTH(image)) {
+        uint8_t i;
+        for (i = 0; i < REGISTER_IMAGE_RUN_LENGTH(image); i++) {
+            cc2500_shadow_store(REGISTER_IMAGE_RUN_ADDRESS(image) + i, REGISTER_IMAGE_RUN_DATA(image)[i]);
+        }
+
+        // one burst write per run of consecutive registers
+        chain[count].header  = REGISTER_IMAGE_RUN_ADDRESS(image) | BURST_FLAG;
+        chain[count].len     = REGISTER_IMAGE_RUN_LENGTH(image);
+        chain[count].tx_data = REGISTER_IMAGE_RUN_DATA(image);
+        chain[count].rx_data = 0;
+        chain[count].action  = 0;
+        count++;
+
+        image = REGISTER_IMAGE_NEXT_RUN(image);
+
+        if ((count == CC2500_REGISTER_IMAGE_CHAIN_SIZE) || !REGISTER_IMAGE_RUN_LENGTH(image)) {
+            if (!cc2500_xfer_chain(chain, count)) {
+                // cc2500_flush_registers() sends the cached runs again
+                debug("cc2500: register image failed\n");
+                cc2500_shadow_mark_dirty(chain, count);
+            }
+            count = 0;
+        }
+    }
+}
+
+// run a chain that lives on the caller's stack and wait for it. main
+// loop only, returns 0 if it was not sent or the chip did not answer
+static uint32_t cc2500_xfer_chain(spi_transaction_t *chain, uint8_t count) {
+    uint32_t retry;
+
+    for (retry = 0; retry < CC2500_XFER_RETRY; retry++) {
+        spi_xfer_wait();
+        cc2500_xfer_result = SPI_XFER_TIMEOUT;
+        if (spi_xfer_async(chain, count, cc2500_xfer_chain_done)) {
+            spi_xfer_wait();
+            return (cc2500_xfer_result == SPI_XFER_OK);
+        }
+        // an isr filled the queue meanwhile
+    }
+    return 0;
+}
+
+static void cc2500_xfer_chain_done(uint32_t result) {
+    cc2500_xfer_result = result;
+}
+
+void cc2500_chain_reset(cc2500_chain_t *chain) {
+    chain->count  = 0;
+    chain->action = 0;
+}
+
+static spi_transaction_t *cc2500_chain_append(cc2500_chain_t *chain, uint8_t header, uint8_t len) {
+    if (chain->count == CC2500_CHAIN_SIZE) {
+        // the callers never queue more steps than this
+        return 0;
+    }
+
+    spi_transaction_t *transaction = &chain->transaction[chain->count];
+    transaction->header  = header;
+    transaction->len     = len;
+    transaction->tx_data = 0;
+    transaction->rx_data = 0;
+    transaction->action  = chain->action;
+
+    chain->action = 0;
+    chain->count++;
+    return transaction;
+}
+
+void cc2500_chain_strobe(cc2500_chain_t *chain, uint8_t strobe) {
+    cc2500_chain_append(chain, strobe, 0);
+}
+
+void cc2500_chain_register(cc2500_chain_t *chain, uint8_t address, uint8_t data) {
+    if (cc2500_shadow_hit(address, data)) {
+        // already set, skip address and data byte
+        return;
+    }
+
+    uint8_t index = chain->count;
+    spi_transaction_t *transaction = cc2500_chain_append(chain, address, 1);
+    if (!transaction) {
+        return;
+    }
+    chain->data[index]   = data;
+    transaction->tx_data = &chain->data[index];
+
+    // the chains are processed in order, later accesses see the new value.
+    // a chain that never made it to the chip is undone by
+    // cc2500_chain_invalidate()
+    cc2500_shadow_store(address, data);
+}
+
+// burst write of consecutive registers, data is sent as is and has to
+// outlive the chain. not tracked by the shadow, for the uncached
+// fscal registers only
+void cc2500_chain_burst(cc2500_chain_t *chain, uint8_t address, const uint8_t *data, uint8_t len) {
+    spi_transaction_t *transaction = cc2500_chain_append(chain, address | BURST_FLAG, len);
+    if (transaction) {
+        transaction->tx_data = data;
+    }
+}
+
+// the value is in *data once the chain completed
+void cc2500_chain_read(cc2500_chain_t *chain, uint8_t address, uint8_t *data) {
+    spi_transaction_t *transaction = cc2500_chain_append(chain, address | READ_FLAG | BURST_FLAG, 1);
+    if (transaction) {
+        transaction->rx_data = data;
+    }
+}
+
+void cc2500_chain_rxmode(cc2500_chain_t *chain) {
+    // LNA = 1 with the next step, PA = 0 with cc2500_chain_receive()
+    chain->action = cc2500_path_rx_lna_on;
+}
+
+void cc2500_chain_receive(cc2500_chain_t *chain) {
+    cc2500_chain_strobe(chain, RFST_SFRX);
+    // the steps since cc2500_chain_rxmode() replace the lna settle delay
+    chain->action = cc2500_path_rx_pa_off;
+    cc2500_chain_strobe(chain, RFST_SRX);
+}
+
+void cc2500_chain_transmit(cc2500_chain_t *chain, const uint8_t *buffer, uint8_t len) {
+    // LNA = 0 and flush tx fifo
+    chain->action = cc2500_path_tx_lna_off;
+    cc2500_chain_strobe(chain, RFST_SFTX);
+
+    // copy to fifo, this takes longer than the lna needs to settle
+    spi_transaction_t *transaction = cc2500_chain_append(chain, CC2500_FIFO | BURST_FLAG, len);
+    if (transaction) {
+        transaction->tx_data = buffer;
+    }
+
+    // PA = 1 and send! the synthesizer settles after STX anyway
+    chain->action = cc2500_path_tx_pa_on;
+    cc2500_chain_strobe(chain, RFST_STX);
+}
+
+uint32_t cc2500_chain_start(cc2500_chain_t *chain, spi_callback_t callback) {
+    // queued behind a running chain, never waits
+    if (!spi_xfer_async(chain->transaction, chain->count, callback)) {
+        cc2500_chain_invalidate(chain);
+        return 0;
+    }
+    return 1;
+}
+
+// the register writes of a chain that failed or timed out may not have
+// reached the chip, forget their shadow values
+void cc2500_chain_invalidate(cc2500_chain_t *chain) {
+    uint32_t i;
+
+    for (i = 0; i < chain->count; i++) {
+        spi_transaction_t *transaction = &chain->transaction[i];
+        if ((transaction->tx_data >= chain->data) &&
+            (transaction->tx_data < chain->data + CC2500_CHAIN_SIZE)) {
+            // written by cc2500_chain_register()
+            cc2500_shadow_forget(transaction->header);
+        }
+    }
+}
+
+static void cc2500_path_tx_lna_off(void) {
+    cc2500_tx_active = 1;
+    gpio_clear(CC2500_LNA_GPIO, CC2500_LNA_PIN);
+}
+
+static void cc2500_path_tx_pa_on(void) {
+    gpio_set(CC2500_PA_GPIO, CC2500_PA_PIN);
+}
+
+static void cc2500_path_rx_lna_on(void) {
+    cc2500_tx_active = 0;
+    gpio_set(CC2500_LNA_GPIO, CC2500_LNA_PIN);
+}
+
+static void cc2500_path_rx_pa_off(void) {
+    gpio_clear(CC2500_PA_GPIO, CC2500_PA_PIN);
+}
+
 /*
 void cc2500_wait_for_transmission_complete(void) {
     // after STX we go back to RX state(see MCSM1 register)
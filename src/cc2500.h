@@ -21,8 +21,11 @@
 #define CC2500_H_
 
 #include <stdint.h>
+#include "spi.h"
+#include "packet_pool.h"
 
 void cc2500_init(void);
+void cc2500_release(void);
 void cc2500_set_register(uint8_t reg, uint8_t val);
 uint8_t cc2500_get_register(uint8_t address);
 void cc2500_strobe(uint8_t val);
@@ -45,12 +48,57 @@ void cc2500_wait_for_transmission_complete(void);
 #define cc2500_partnum_valid(p, v) ((p == 0x80) && (v = 0x03))
 
 uint8_t cc2500_get_status(void);
+uint32_t cc2500_select(void);
+void cc2500_deselect(void);
 uint32_t cc2500_set_antenna(uint8_t id);
 void cc2500_set_gdo_mode(void);
 uint8_t cc2500_get_gdo_status(void);
 void cc2500_process_packet(volatile uint8_t *packet_received, volatile uint8_t *buf, uint8_t max);
 void cc2500_transmit_packet(volatile uint8_t *buffer, uint8_t len);
 
+// packet events, signalled from isr context
+#define CC2500_EVENT_SYNC      0
+#define CC2500_EVENT_TX_DONE   1
+#define CC2500_EVENT_RX_DONE   2
+#define CC2500_EVENT_RX_ERROR  3
+// on CC2500_EVENT_RX_DONE the callback owns packet and has to free it
+typedef void (*cc2500_packet_callback_t)(uint32_t event, packet_buffer_t *packet);
+void cc2500_set_packet_callback(cc2500_packet_callback_t callback, uint8_t rx_len);
+int8_t cc2500_get_rx_freq_estimate(void);
+void cc2500_write_register_image(const uint8_t *image);
+void cc2500_queue_register(uint8_t address, uint8_t data);
+void cc2500_flush_registers(void);
+uint32_t cc2500_get_spi_bytes_saved(void);
+uint32_t cc2500_get_spi_bytes_saved_per_second(void);
+
+// transactions built in isr context and sent as one dma chain, the
+// isr only enqueues. the pa/lna path is switched in between two steps
+#define CC2500_CHAIN_SIZE 10
+typedef struct {
+    spi_transaction_t transaction[CC2500_CHAIN_SIZE];
+    // register values, the chain outlives its builder
+    uint8_t data[CC2500_CHAIN_SIZE];
+    uint8_t count;
+    // attached to the next step
+    void (*action)(void);
+} cc2500_chain_t;
+void cc2500_chain_reset(cc2500_chain_t *chain);
+void cc2500_chain_strobe(cc2500_chain_t *chain, uint8_t strobe);
+void cc2500_chain_register(cc2500_chain_t *chain, uint8_t address, uint8_t data);
+void cc2500_chain_read(cc2500_chain_t *chain, uint8_t address, uint8_t *data);
+void cc2500_chain_burst(cc2500_chain_t *chain, uint8_t address, const uint8_t *data, uint8_t len);
+void cc2500_chain_rxmode(cc2500_chain_t *chain);
+void cc2500_chain_receive(cc2500_chain_t *chain);
+void cc2500_chain_transmit(cc2500_chain_t *chain, const uint8_t *buffer, uint8_t len);
+uint32_t cc2500_chain_start(cc2500_chain_t *chain, spi_callback_t callback);
+void cc2500_chain_invalidate(cc2500_chain_t *chain);
+
+// FSCAL3, FSCAL2 and FSCAL1 are the result of one pll calibration, they
+// are saved per channel for fast hopping and restored as one burst
+#define CC2500_FSCAL_COUNT 3
+void cc2500_fscal_save(uint8_t *fscal);
+void cc2500_fscal_load(const uint8_t *fscal);
+
 void cc2500_read_fifo(uint8_t *buf, uint8_t len);
 void cc2500_register_read_multi(uint8_t address, uint8_t *buffer, uint8_t len);
 uint8_t cc2500_transmission_completed(void);
@@ -81,7 +81,10 @@ void config_detect_hw_revision(void);
 
 // irq priorities
 #define NVIC_PRIO_FRSKY      0*64
+// below frsky: a long a7105 callback must never delay a frsky slot
+#define NVIC_PRIO_PROTOCOL   1*64
 #define NVIC_PRIO_SYSTICK    1*64
+#define NVIC_PRIO_ADC        2*64
 #define NVIC_PRIO_TOUCH      3*64
 
 // touch
@@ -105,8 +108,12 @@ void config_detect_hw_revision(void);
 
 
 #define ADC_DMA_CHANNEL           DMA_CHANNEL1
-#define ADC_DMA_TC_FLAG           DMA_ISR_TCIF1
+#define ADC_DMA_IRQ               NVIC_DMA1_CHANNEL1_IRQ
 #define ADC_CHANNEL_COUNT 11
+// conversion sequences are triggered by TIM15 TRGO
+#define ADC_TIMER                 TIM15
+#define ADC_TIMER_CLOCK           RCC_TIM15
+#define ADC_TIMER_TRIGGER         ADC_CFGR1_EXTSEL_TIM15_TRGO
 
 // cc2500 module connection
 // SI = SDIO
@@ -150,6 +157,32 @@ void config_detect_hw_revision(void);
 #define CC2500_GDO2_GPIO           GPIOB
 #define CC2500_GDO2_PIN            GPIO2
 
+#define CC2500_GDO2_EXTI_SOURCE       GPIOB
+#define CC2500_GDO2_EXTI_SOURCE_LINE  EXTI2
+#define CC2500_GDO2_EXTI_IRQN         NVIC_EXTI2_3_IRQ
+
+// a7105 module connection (3-wire spi, SDIO is bidirectional)
+// the stock a7105 module and the cc2500 adapter (see pcb/) use the same
+// pads: SDIO, SCK, SCS, GIO1, GIO2, RX/W and TX/W. only one of them is
+// fitted, the module on the pads is detected at boot (see radio.c)
+#define A7105_SPI_GPIO             CC2500_SPI_GPIO
+// LABELED SCK
+#define A7105_SPI_SCK_PIN          CC2500_SPI_SCK_PIN
+// LABELED SPIO
+#define A7105_SPI_SDIO_PIN         CC2500_SPI_MOSI_PIN
+// LABELED SCS
+#define A7105_SPI_CS_GPIO          CC2500_SPI_GPIO
+#define A7105_SPI_CS_PIN           CC2500_SPI_CSN_PIN
+#define A7105_SPI                  CC2500_SPI
+#define A7105_SPI_CLK              CC2500_SPI_CLK
+#define A7105_SPI_TX_DMA_CHANNEL   CC2500_SPI_TX_DMA_CHANNEL
+#define A7105_SPI_RX_DMA_CHANNEL   CC2500_SPI_RX_DMA_CHANNEL
+// LABELED TX_W and RX-W
+#define A7105_TXW_GPIO             CC2500_PA_GPIO
+#define A7105_TXW_PIN              CC2500_PA_PIN
+#define A7105_RXW_GPIO             CC2500_LNA_GPIO
+#define A7105_RXW_PIN              CC2500_LNA_PIN
+
 // BUTTONS
 #define BUTTON_POWER_BOTH_GPIO        GPIOB
 #define BUTTON_POWER_BOTH_PIN         GPIO14
@@ -121,6 +121,61 @@ bool fifo_put(fifo_buffer_t * b, uint8_t data_byte) {
     return status;
 }
 
+/****************************************************************************
+* DESCRIPTION: Gets up to max_len bytes from the front of the list
+* RETURN:      number of bytes copied to data
+* ALGORITHM:   none
+* NOTES:       tail is updated once, after all bytes were copied
+*****************************************************************************/
+unsigned fifo_read_block(fifo_buffer_t * b, uint8_t *data, unsigned max_len) {
+    unsigned count, tail, i;
+
+    if (!b || !data) {
+        return 0;
+    }
+
+    count = fifo_count(b);
+    if (count > max_len) {
+        count = max_len;
+    }
+
+    tail = b->tail;
+    for (i = 0; i < count; i++) {
+        data[i] = b->buffer[(tail + i) % b->buffer_len];
+    }
+    b->tail = tail + count;
+
+    return count;
+}
+
+/****************************************************************************
+* DESCRIPTION: Adds a block of data to the FIFO
+* RETURN:      number of bytes added, less than len if the FIFO got full
+* ALGORITHM:   none
+* NOTES:       head is updated once, after all bytes were stored
+*****************************************************************************/
+unsigned fifo_write_block(fifo_buffer_t * b, const uint8_t *data, unsigned len) {
+    unsigned space, head, i;
+
+    if (!b || !data) {
+        return 0;
+    }
+
+    /* limit the ring to prevent overwriting */
+    space = b->buffer_len - fifo_count(b);
+    if (len > space) {
+        len = space;
+    }
+
+    head = b->head;
+    for (i = 0; i < len; i++) {
+        b->buffer[(head + i) % b->buffer_len] = data[i];
+    }
+    b->head = head + len;
+
+    return len;
+}
+
 /****************************************************************************
 * DESCRIPTION: Configures the ring buffer
 * RETURN:      none
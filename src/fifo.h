@@ -58,6 +58,10 @@ uint8_t fifo_get(fifo_buffer_t * b);
 
 bool fifo_put(fifo_buffer_t * b, uint8_t data_byte);
 
+unsigned fifo_read_block(fifo_buffer_t * b, uint8_t *data, unsigned max_len);
+
+unsigned fifo_write_block(fifo_buffer_t * b, const uint8_t *data, unsigned len);
+
 /* note: buffer_len must be a power of two */
 void fifo_init(fifo_buffer_t * b, volatile uint8_t *buffer, unsigned buffer_len);
 
@@ -31,15 +31,212 @@
 #include "storage.h"
 #include "adc.h"
 #include "telemetry.h"
+#include "mixer.h"
+#include "radio.h"
+#include "linkstats.h"
+#include "macros.h"
+#include "register_image.h"
+#include "protocol/common.h"
 
 #include <libopencm3/stm32/timer.h>
 
+// internal functions
+static void frsky_isr_handle_slot(void);
+static void frsky_build_packet(uint8_t *packet);
+static void frsky_build_bindpacket(uint8_t *packet, uint8_t bind_packet_id);
+static void frsky_update_channel_snapshot(void);
+static void frsky_update_mixer_compare(void);
+static void frsky_process_telemetry(const uint8_t *packet);
+static void frsky_packet_event(uint32_t event, packet_buffer_t *packet);
+static void frsky_slot_chain_done(uint32_t result);
+static void frsky_slot_chain_start(void);
+static void frsky_chain_channel(cc2500_chain_t *chain, uint8_t hop_index);
+static void frsky_chain_packet(cc2500_chain_t *chain, packet_buffer_t *packet);
+static void frsky_afc_reset(void);
+static void frsky_load_registers(void);
+static uint8_t frsky_slot_is_rx(void);
+static void frsky_afc_update(int8_t estimate);
+static void frsky_afc_handle_persist(void);
+static void frsky_clone_process_packet(const uint8_t *packet);
+static void frsky_clone_listen(int8_t offset);
+static void frsky_clone_wait(uint32_t ms);
+static uint16_t frsky_autotune_score(int8_t offset);
+
+// d8 frame cycle: every tick hops to the next channel,
+// the first slots transmit channel data, the last slot
+// listens for the telemetry packet of the receiver
+#define FRSKY_SLOT_COUNT       4
+#define FRSKY_SLOT_RX          (FRSKY_SLOT_COUNT - 1)
+#define FRSKY_COUNTER_MAX      (4 * FRSKY_HOPTABLE_SIZE)
+#define FRSKY_BINDPACKET_COUNT 10
+#define FRSKY_TX_PACKET_SIZE   (FRSKY_PACKET_LENGTH + 1)
+
+// slot time and telemetry slot per frame rate mode
+typedef struct {
+    uint16_t slot_us;
+    uint8_t telemetry;
+    char *name;
+} frsky_rate_t;
+
+static const frsky_rate_t frsky_rate_table[FRSKY_RATE_COUNT] = {
+    [FRSKY_RATE_STANDARD]         = { .slot_us = 9000, .telemetry = 1, .name = "9MS"    },
+    [FRSKY_RATE_FAST]             = { .slot_us = 4500, .telemetry = 1, .name = "4.5MS"  },
+    [FRSKY_RATE_FAST_NOTELEMETRY] = { .slot_us = 4500, .telemetry = 0, .name = "4.5MS-" },
+};
+
+// automatic frequency control: the FREQEST of every valid telemetry
+// packet is low pass filtered (q4 fixed point) and moves FSCTRL0 by at
+// most one step per packet. a new offset is saved after it was stable
+// for some minutes, the flash write costs a few frames
+#define FRSKY_AFC_FILTER_SHIFT 3
+#define FRSKY_AFC_STEP_Q4      16
+#define FRSKY_AFC_PERSIST_MS   (5 * 60 * 1000UL)
+
+// clone: bind packets are sent every 9ms on channel 0. autotune does a
+// coarse sweep over the offset range and then probes both neighbours
+// of the best offset with a halving step, scoring each offset by the
+// link quality of the bind packets heard within one listen window
+#define FRSKY_AUTOTUNE_WINDOW_MS   40
+#define FRSKY_AUTOTUNE_COARSE_MIN  (-96)
+#define FRSKY_AUTOTUNE_COARSE_MAX  96
+#define FRSKY_AUTOTUNE_COARSE_STEP 16
+#define FRSKY_HOPTABLE_WINDOW_MS   50
+#define FRSKY_BINDPACKET_HOPS      5
+
+#define FRSKY_AUTOTUNE_STATE_COARSE 0
+#define FRSKY_AUTOTUNE_STATE_FINE   1
+
+// +/-CHAN_MAX_VALUE -> +/-750 (us * 1.5) as q20 multiply and shift,
+// the clamped mixer output times the factor stays within int32
+#define FRSKY_CHANNEL_SCALE_SHIFT 20
+#define FRSKY_CHANNEL_SCALE       (((750UL << FRSKY_CHANNEL_SCALE_SHIFT) + CHAN_MAX_VALUE / 2) / CHAN_MAX_VALUE)
+
+// MCSM0 with and without calibration on every idle -> rx/tx transition
+#define FRSKY_MCSM0_AUTOCAL    0x18
+#define FRSKY_MCSM0_MANUALCAL  0x08
+
+// d8 register set, FSCTRL0 is written separately (frequency offset).
+// registers without a d8 specific setting are set to their reset value
+static const uint8_t frsky_register_image[] = {
+    REGISTER_IMAGE_RUN(FIFOTHR, 1),
+        0x07,
+    // PKTLEN ... FSCTRL1
+    REGISTER_IMAGE_RUN(PKTLEN, 6),
+        0x19, 0x04, 0x05, 0x00, 0x00, 0x08,
+    // FREQ2 ... TEST0
+    REGISTER_IMAGE_RUN(FREQ2, 34),
+        0x5C, 0x76, 0x27, 0xAA, 0x39, 0x11, 0x23, 0x7A,
+        0x42, 0x07, 0x0C, 0x18, 0x16, 0x6C, 0x03, 0x40,
+        0x91, 0x87, 0x6B, 0xF8, 0x56, 0x10, 0xA9, 0x0A,
+        0x00, 0x11, 0x41, 0x00, 0x59, 0x7F, 0x3F, 0x88,
+        0x31, 0x0B,
+    REGISTER_IMAGE_RUN(PA_TABLE0, 1),
+        0xFF,
+    REGISTER_IMAGE_END
+};
+
+// pll calibration per hop channel. the vco and charge pump settings in
+// fscal3/fscal2 depend on the frequency as well, the datasheet asks to
+// store all three for fast hopping without calibration
+static uint8_t frsky_calib_table[FRSKY_HOPTABLE_SIZE][CC2500_FSCAL_COUNT];
+
+// a cc2500 answered on the rf pads
+static uint8_t frsky_fitted;
+
+static volatile uint8_t frsky_rate;
+static volatile uint16_t frsky_slot_period_us;
+static volatile uint8_t frsky_slot;
+static volatile uint8_t frsky_counter;
+static volatile uint8_t frsky_bind_mode;
+static uint8_t frsky_bind_packet_id;
+
+// channel data for the next packet, computed by the compare match the
+// mixer lead time before each data slot (or after each upload without one)
+static uint16_t frsky_channel_snapshot[8];
+
+// packet being uploaded to the cc2500, released by the spi dma isr
+static packet_buffer_t *volatile frsky_tx_inflight;
+
+// spi steps of one slot, queued by the slot isr and run by the dma isr
+static cc2500_chain_t frsky_slot_chain;
+static volatile uint8_t frsky_slot_chain_busy;
+
+// afc state, the offset is written to FSCTRL0 by the next data slot
+static int16_t frsky_afc_filtered;
+static volatile int8_t frsky_afc_offset;
+static volatile uint8_t frsky_afc_pending;
+static int8_t frsky_afc_last_offset;
+static uint32_t frsky_afc_stable_since;
+// last offset that was stable long enough, stored by the next storage save
+static int8_t frsky_afc_converged;
+
+// clone state, bind packets are evaluated by the packet isr
+static volatile uint8_t frsky_clone_active;
+static volatile uint8_t frsky_clone_rx_error;
+static volatile uint16_t frsky_clone_quality;
+static volatile uint8_t frsky_clone_capture;
+static volatile uint64_t frsky_clone_hop_valid;
+static uint8_t frsky_clone_txid[2];
+static uint8_t frsky_clone_hop_table[FRSKY_HOPTABLE_SIZE];
+
+// autotune search state
+static uint8_t frsky_autotune_state;
+static int8_t frsky_autotune_offset;
+static int8_t frsky_autotune_best;
+static uint16_t frsky_autotune_best_score;
+static int8_t frsky_autotune_step;
+
+// telemetry window that is still waiting for its packet
+static volatile uint8_t frsky_rx_pending;
+static volatile uint8_t frsky_rx_hop_index;
+
+static volatile uint8_t frsky_rssi;
+static volatile uint8_t frsky_rssi_telemetry;
+
+// isr runtime in us (measured against the 1MHz timer count)
+static volatile uint16_t frsky_slot_time_us;
+static volatile uint16_t frsky_slot_time_max_us;
+
+// per slot budget checks
+static volatile uint8_t frsky_tx_on_air;
+static volatile frsky_overruns_t frsky_overruns;
+
 void frsky_init(void) {
     // uint8_t i;
     debug("frsky: init\n"); debug_flush();
 
+    cc2500_init();
+
     telemetry_init();
 
+    // the stock a7105 module may still sit on the rf pads
+    frsky_fitted = frsky_check_transceiver();
+    if (!frsky_fitted) {
+        debug("frsky: no cc2500 found\n"); debug_flush();
+        cc2500_release();
+        return;
+    }
+
+    frsky_configure();
+
+    frsky_calib_pll();
+
+    // telemetry packets are read by dma straight into a pool buffer
+    cc2500_set_packet_callback(frsky_packet_event, FRSKY_PACKET_BUFFER_SIZE);
+
+    frsky_slot    = 0;
+    frsky_counter = 0;
+    frsky_bind_mode = 0;
+    frsky_tx_on_air = 0;
+    frsky_slot_chain_busy = 0;
+    frsky_reset_overruns();
+    frsky_rate = storage.model[storage.current_model].frsky_rate;
+    if (frsky_rate >= FRSKY_RATE_COUNT) {
+        frsky_rate = FRSKY_RATE_STANDARD;
+    }
+    frsky_slot_period_us = frsky_rate_table[frsky_rate].slot_us;
+    frsky_update_channel_snapshot();
+
     frsky_init_timer();
 
     frsky_tx_set_enabled(1);
@@ -47,6 +244,64 @@ void frsky_init(void) {
     debug("frsky: init done\n"); debug_flush();
 }
 
+uint8_t frsky_check_transceiver(void) {
+    // check if we are talking to a cc2500
+    uint8_t partnum = cc2500_get_register_burst(PARTNUM);
+    uint8_t version = cc2500_get_register_burst(VERSION);
+
+    debug("frsky: partnum 0x"); debug_put_hex8(partnum);
+    debug(" version 0x"); debug_put_hex8(version); debug_put_newline();
+    debug_flush();
+
+    return ((partnum == 0x80) && (version == 0x03));
+}
+
+uint8_t frsky_is_fitted(void) {
+    return frsky_fitted;
+}
+
+void frsky_configure(void) {
+    debug("frsky: configure\n"); debug_flush();
+
+    frsky_afc_reset();
+    frsky_load_registers();
+}
+
+static void frsky_load_registers(void) {
+    // start idle
+    cc2500_strobe(RFST_SIDLE);
+
+    // d8 register set
+    cc2500_write_register_image(frsky_register_image);
+    cc2500_set_register(FSCTRL0, frsky_afc_offset);
+    cc2500_set_gdo_mode();
+
+    // flush fifos
+    cc2500_strobe(RFST_SFRX);
+    cc2500_strobe(RFST_SFTX);
+}
+
+// take the cc2500 back after the scanner used it. the caller stopped the
+// tx isr. telemetry, link stats and the afc state are kept
+void frsky_resume(void) {
+    if (!frsky_fitted) {
+        return;
+    }
+
+    debug("frsky: resume\n"); debug_flush();
+
+    frsky_load_registers();
+
+    // the pll calibration cache of the hop channels is still valid,
+    // every hop loads its own
+    cc2500_set_register(MCSM0, FRSKY_MCSM0_MANUALCAL);
+
+    cc2500_set_packet_callback(frsky_packet_event, FRSKY_PACKET_BUFFER_SIZE);
+    frsky_slot = 0;
+
+    frsky_tx_set_enabled(1);
+}
+
 void frsky_init_timer(void) {
     // TIM3 clock enable
     rcc_periph_clock_enable(RCC_TIM3);
@@ -59,7 +314,7 @@ void frsky_init_timer(void) {
     nvic_set_priority(NVIC_TIM3_IRQ, NVIC_PRIO_FRSKY);
 
     // compute prescaler value
-    // we want one ISR every 9ms
+    // we want one ISR every slot (9ms for stock d8)
     // setting TIM_Period to 9000 will reuqire
     // a prescaler so that one timer tick is 1us (1MHz)
     uint16_t prescaler = (uint16_t) (rcc_timer_frequency  / 1000000) - 1;
@@ -67,8 +322,15 @@ void frsky_init_timer(void) {
     // time base as calculated above
     timer_set_prescaler(TIM3, prescaler);
     timer_set_mode(TIM3, TIM_CR1_CKD_CK_INT, TIM_CR1_CMS_EDGE, TIM_CR1_DIR_UP);
-    // timer should count with 1MHz thus 9000 ticks = 9ms
-    timer_set_period(TIM3, 9000-1);
+    // timer should count with 1MHz thus 9000 ticks = 9ms.
+    // rate changes load the new period with the next update event
+    timer_enable_preload(TIM3);
+    timer_set_period(TIM3, frsky_slot_period_us - 1);
+
+    // compare 1 triggers the mixer pass ahead of the next slot
+    timer_disable_oc_output(TIM3, TIM_OC1);
+    timer_set_oc_mode(TIM3, TIM_OC1, TIM_OCM_FROZEN);
+    frsky_update_mixer_compare();
 
     // DO NOT ENABLE INT yet!
 
@@ -77,13 +339,21 @@ void frsky_init_timer(void) {
 }
 
 void frsky_tx_set_enabled(uint32_t enabled) {
+    if (!frsky_fitted) {
+        // tim3 was never set up
+        return;
+    }
+
     // TIM Interrupts enable? -> tx active
     if (enabled) {
+        // tx and clone listening exclude each other
+        frsky_clone_active = 0;
+
         // enable ISR
-        timer_enable_irq(TIM3, TIM_DIER_UIE);
+        timer_enable_irq(TIM3, TIM_DIER_UIE | TIM_DIER_CC1IE);
     } else {
         // stop ISR
-        timer_disable_irq(TIM3, TIM_DIER_UIE);
+        timer_disable_irq(TIM3, TIM_DIER_UIE | TIM_DIER_CC1IE);
         // make sure last packet was sent
         delay_ms(20);
     }
@@ -92,23 +362,472 @@ void frsky_tx_set_enabled(uint32_t enabled) {
 void frsky_handle_telemetry(void) {
     // handle incoming telemetry data
     telemetry_process();
+
+    // remember a converged frequency offset
+    frsky_afc_handle_persist();
+}
+
+static void frsky_afc_reset(void) {
+    // start tracking from the stored offset
+    frsky_afc_filtered     = 0;
+    frsky_afc_pending      = 0;
+    frsky_afc_offset       = storage.frsky_freq_offset;
+    frsky_afc_last_offset  = storage.frsky_freq_offset;
+    frsky_afc_converged    = storage.frsky_freq_offset;
+    frsky_afc_stable_since = timeout_get_ms();
+}
+
+static void frsky_afc_update(int8_t estimate) {
+    int8_t step;
+
+    // FREQEST is the residual offset with the current FSCTRL0 applied
+    frsky_afc_filtered += ((int16_t)estimate * FRSKY_AFC_STEP_Q4 - frsky_afc_filtered) >> FRSKY_AFC_FILTER_SHIFT;
+
+    if (frsky_afc_filtered >= FRSKY_AFC_STEP_Q4) {
+        step = 1;
+    } else if (frsky_afc_filtered <= -FRSKY_AFC_STEP_Q4) {
+        step = -1;
+    } else {
+        return;
+    }
+
+    // stay within the FSCTRL0 range
+    if ((step > 0) && (frsky_afc_offset == INT8_MAX)) return;
+    if ((step < 0) && (frsky_afc_offset == INT8_MIN)) return;
+
+    // the residual shrinks by the step we apply
+    frsky_afc_offset   += step;
+    frsky_afc_filtered -= step * FRSKY_AFC_STEP_Q4;
+    frsky_afc_pending   = 1;
+}
+
+static void frsky_afc_handle_persist(void) {
+    uint32_t now = timeout_get_ms();
+    int8_t offset = frsky_afc_offset;
+
+    if (offset != frsky_afc_last_offset) {
+        // still moving
+        frsky_afc_last_offset  = offset;
+        frsky_afc_stable_since = now;
+        return;
+    }
+
+    if (offset == frsky_afc_converged) {
+        return;
+    }
+
+    if ((now - frsky_afc_stable_since) < FRSKY_AFC_PERSIST_MS) {
+        return;
+    }
+
+    // a flash write stalls the cpu, it is left to the next save while rf is idle
+    debug("frsky: afc converged at 0x"); debug_put_hex8(offset); debug_put_newline();
+    frsky_afc_converged = offset;
+}
+
+// copy a converged offset to the storage, returns 1 if the storage changed.
+// the caller saves the storage
+uint32_t frsky_afc_store(void) {
+    if (storage.frsky_freq_offset == frsky_afc_converged) {
+        return 0;
+    }
+    storage.frsky_freq_offset = frsky_afc_converged;
+    return 1;
 }
 
 void frsky_get_rssi(uint8_t *rssi, uint8_t *rssi_telemetry) {
-    *rssi           = 0;
-    *rssi_telemetry = 0;
+    *rssi           = frsky_rssi;
+    *rssi_telemetry = frsky_rssi_telemetry;
+}
+
+void frsky_get_slot_timing(uint16_t *last_us, uint16_t *max_us) {
+    *last_us = frsky_slot_time_us;
+    *max_us  = frsky_slot_time_max_us;
+}
+
+void frsky_set_rate(uint8_t rate) {
+    if (rate >= FRSKY_RATE_COUNT) {
+        return;
+    }
+
+    debug("frsky: rate "); debug(frsky_rate_table[rate].name); debug_put_newline();
+    debug_flush();
+
+    // the isr picks up the telemetry setting with the next slot,
+    // the period is preloaded and switches with the next update event
+    frsky_rate = rate;
+    frsky_slot_period_us = frsky_rate_table[rate].slot_us;
+    if (frsky_fitted) {
+        timer_set_period(TIM3, frsky_slot_period_us - 1);
+    }
+    frsky_reset_overruns();
+
+    // shorter slots leave less room for the a7105 protocol
+    radio_a7105_check();
+}
+
+uint8_t frsky_get_rate(void) {
+    return frsky_rate;
+}
+
+char *frsky_get_rate_name(uint8_t rate) {
+    if (rate >= FRSKY_RATE_COUNT) {
+        return "?";
+    }
+    return frsky_rate_table[rate].name;
+}
+
+uint16_t frsky_get_slot_period_us(void) {
+    return frsky_slot_period_us;
+}
+
+// the telemetry reply may arrive any time until the next slot
+uint16_t frsky_get_rx_window_us(void) {
+    if (!frsky_rate_table[frsky_rate].telemetry) {
+        return 0;
+    }
+    return frsky_slot_period_us;
+}
+
+void frsky_get_overruns(frsky_overruns_t *overruns) {
+    overruns->isr    = frsky_overruns.isr;
+    overruns->upload = frsky_overruns.upload;
+    overruns->air    = frsky_overruns.air;
+}
+
+void frsky_reset_overruns(void) {
+    frsky_overruns.isr    = 0;
+    frsky_overruns.upload = 0;
+    frsky_overruns.air    = 0;
+    frsky_slot_time_max_us = 0;
 }
 
 void TIM3_IRQHandler(void)
 {
+    if (timer_get_flag(TIM3, TIM_SR_CC1IF)) {
+        timer_clear_flag(TIM3, TIM_SR_CC1IF);
+
+        // just in time mixer pass for the upcoming data slot
+        if (!frsky_bind_mode && !frsky_slot_is_rx()) {
+            frsky_update_channel_snapshot();
+        }
+    }
+
     if (timer_get_flag(TIM3, TIM_SR_UIF)){
         // clear flag (NOTE: this should never be done at the end of the ISR)
         timer_clear_flag(TIM3, TIM_SR_UIF);
+
+        frsky_isr_handle_slot();
+        frsky_update_mixer_compare();
+
+        // the counter was reset by the update event, thus it holds
+        // the time we spent in here (1 tick = 1us)
+        uint16_t runtime = timer_get_counter(TIM3);
+        frsky_slot_time_us = runtime;
+        if (runtime > frsky_slot_time_max_us) {
+            frsky_slot_time_max_us = runtime;
+        }
+
+        if (timer_get_flag(TIM3, TIM_SR_UIF)) {
+            // the next slot is already due, the counter wrapped
+            frsky_overruns.isr++;
+        }
+    }
+}
+
+static uint8_t frsky_slot_is_rx(void) {
+    return (frsky_slot == FRSKY_SLOT_RX) && frsky_rate_table[frsky_rate].telemetry;
+}
+
+static void frsky_isr_handle_slot(void) {
+    packet_buffer_t *tx;
+    cc2500_chain_t *chain = &frsky_slot_chain;
+    uint8_t slot = frsky_slot;
+    uint8_t rx_slot = frsky_slot_is_rx();
+    uint8_t hop_index;
+
+    if (frsky_bind_mode) {
+        if (frsky_slot_chain_busy) {
+            // never touch a chain in flight, retry with the next slot
+            frsky_overruns.upload++;
+            return;
+        }
+        frsky_send_bindpacket(frsky_bind_packet_id);
+        frsky_bind_packet_id = (frsky_bind_packet_id + 1) % FRSKY_BINDPACKET_COUNT;
+        return;
+    }
+
+    if (frsky_tx_on_air) {
+        frsky_overruns.air++;
+        frsky_tx_on_air = 0;
+    }
+
+    // hop to next channel, the hopping goes on even if this slot is lost
+    frsky_counter = (frsky_counter + 1) % FRSKY_COUNTER_MAX;
+    hop_index = frsky_counter % FRSKY_HOPTABLE_SIZE;
+
+    // without telemetry the rx slot carries data as well
+    frsky_slot = rx_slot ? 0 : (slot + 1) % FRSKY_SLOT_COUNT;
+
+    if ((slot == 0) && frsky_rx_pending) {
+        // the rx window closed without a valid packet
+        frsky_rx_pending = 0;
+        linkstats_add_loss(frsky_rx_hop_index);
+    }
+
+    if (frsky_slot_chain_busy) {
+        // the last slot has to be done by now, skip this one
+        frsky_overruns.upload++;
+        return;
+    }
+
+    cc2500_chain_reset(chain);
+
+    if (rx_slot) {
+        // open the telemetry rx window, keep the a7105 quiet meanwhile
+        radio_guard_start(frsky_get_rx_window_us());
+        frsky_rx_hop_index = hop_index;
+        frsky_rx_pending   = 1;
+        cc2500_chain_rxmode(chain);
+        frsky_chain_channel(chain, hop_index);
+        cc2500_chain_receive(chain);
+        frsky_slot_chain_start();
+        return;
+    }
+
+    if (slot == 0) {
+        // first data slot, the reply of the last rx window was already
+        // handled by the packet isr. drop anything left in the rx fifo
+        cc2500_chain_strobe(chain, RFST_SIDLE);
+        cc2500_chain_strobe(chain, RFST_SFRX);
+
+        if (frsky_afc_pending) {
+            // apply the tracked frequency offset while idle
+            cc2500_chain_register(chain, FSCTRL0, frsky_afc_offset);
+            frsky_afc_pending = 0;
+        }
+    }
+
+    frsky_chain_channel(chain, hop_index);
+
+    // build the packet in place, it is handed to the dma as is
+    tx = packet_pool_alloc(PACKET_OWNER_BUILDER);
+    if (tx) {
+        frsky_build_packet(tx->data);
+        mixer_frame_sent();
+        frsky_chain_packet(chain, tx);
+    }
+
+    frsky_slot_chain_start();
+
+    if (!mixer_get_lead_time()) {
+        // no mixer lead time, the channel data for the next slot
+        // is prepared while the radio is busy sending this one
+        frsky_update_channel_snapshot();
+    }
+}
+
+static void frsky_slot_chain_start(void) {
+    frsky_slot_chain_busy = 1;
+
+    if (!cc2500_chain_start(&frsky_slot_chain, frsky_slot_chain_done)) {
+        // spi queue full, give the buffer back and drop this slot
+        frsky_slot_chain_done(SPI_XFER_TIMEOUT);
+        frsky_tx_on_air = 0;
+        frsky_overruns.upload++;
     }
 }
 
+static void frsky_slot_chain_done(uint32_t result) {
+    if (result != SPI_XFER_OK) {
+        // the chip did not answer, its registers are unknown now
+        cc2500_chain_invalidate(&frsky_slot_chain);
+    }
+    if (frsky_tx_inflight) {
+        packet_pool_free(frsky_tx_inflight);
+        frsky_tx_inflight = 0;
+    }
+    frsky_slot_chain_busy = 0;
+}
+
+static void frsky_chain_channel(cc2500_chain_t *chain, uint8_t hop_index) {
+    // go to idle, tune to the hop channel and load the cached pll calibration
+    cc2500_chain_strobe(chain, RFST_SIDLE);
+    cc2500_chain_register(chain, CHANNR, storage.frsky_hop_table[hop_index]);
+    cc2500_chain_burst(chain, FSCAL3, frsky_calib_table[hop_index], CC2500_FSCAL_COUNT);
+}
+
+static void frsky_update_channel_snapshot(void) {
+    uint32_t i;
+
+    mixer_process();
+
+    for (i = 0; i < 8; i++) {
+        // frsky packets send us * 1.5, +/-CHAN_MAX_VALUE maps to 1500..3000
+        int32_t scaled = Channels[i] * (int32_t)FRSKY_CHANNEL_SCALE;
+        frsky_channel_snapshot[i] = 2250 + ((scaled + (1L << (FRSKY_CHANNEL_SCALE_SHIFT - 1))) >>
+                                            FRSKY_CHANNEL_SCALE_SHIFT);
+    }
+}
+
+static void frsky_update_mixer_compare(void) {
+    // a compare value beyond the period never matches (= no lead time)
+    uint16_t period = frsky_slot_period_us;
+    uint16_t lead = mixer_get_lead_time();
+    if (lead >= period) {
+        // the lead time can not exceed a fast slot
+        lead = period - 1;
+    }
+    timer_set_oc_value(TIM3, TIM_OC1, period - lead);
+}
+
+static void frsky_build_packet(uint8_t *packet) {
+    uint32_t i;
+
+    // packet header
+    packet[0] = FRSKY_PACKET_LENGTH;
+    packet[1] = storage.frsky_txid[0];
+    packet[2] = storage.frsky_txid[1];
+    packet[3] = frsky_counter;
+    packet[4] = 0x00;
+    packet[5] = 0x01;
+
+    // high nibbles are or'ed in below
+    packet[10] = 0;
+    packet[11] = 0;
+    packet[16] = 0;
+    packet[17] = 0;
+
+    // channel data, 12bit each
+    for (i = 0; i < 8; i++) {
+        uint16_t value = frsky_channel_snapshot[i];
+        if (i < 4) {
+            packet[6 + i] = value & 0xFF;
+            packet[10 + (i >> 1)] |= ((value >> 8) & 0x0F) << (4 * (i & 0x01));
+        } else {
+            packet[8 + i] = value & 0xFF;
+            packet[16 + ((i - 4) >> 1)] |= ((value >> 8) & 0x0F) << (4 * ((i - 4) & 0x01));
+        }
+    }
+}
+
+static void frsky_build_bindpacket(uint8_t *packet, uint8_t bind_packet_id) {
+    uint32_t i;
+    uint8_t idx = bind_packet_id * 5;
+
+    packet[0] = FRSKY_PACKET_LENGTH;
+    packet[1] = 0x03;
+    packet[2] = 0x01;
+    packet[3] = storage.frsky_txid[0];
+    packet[4] = storage.frsky_txid[1];
+    packet[5] = idx;
+
+    // five hop table entries per packet
+    for (i = 0; i < 5; i++) {
+        if ((idx + i) < FRSKY_HOPTABLE_SIZE) {
+            packet[6 + i] = storage.frsky_hop_table[idx + i];
+        } else {
+            packet[6 + i] = 0;
+        }
+    }
+
+    for (i = 11; i < FRSKY_TX_PACKET_SIZE; i++) {
+        packet[i] = 0;
+    }
+    packet[17] = 0x01;
+}
+
+static void frsky_chain_packet(cc2500_chain_t *chain, packet_buffer_t *packet) {
+    packet->len = FRSKY_TX_PACKET_SIZE;
+
+    // released by frsky_slot_chain_done() once the upload is done
+    packet_pool_handoff(packet, PACKET_OWNER_DMA);
+    frsky_tx_inflight = packet;
+    frsky_tx_on_air   = 1;
+
+    // switch antenna path to tx and send
+    cc2500_chain_transmit(chain, packet->data, packet->len);
+}
+
+static void frsky_packet_event(uint32_t event, packet_buffer_t *packet) {
+    switch (event) {
+        case (CC2500_EVENT_RX_DONE) :
+            // telemetry or bind packet arrived, decode it in place
+            if (frsky_clone_active) {
+                frsky_clone_process_packet(packet->data);
+            } else {
+                frsky_process_telemetry(packet->data);
+            }
+            packet_pool_free(packet);
+            break;
+
+        case (CC2500_EVENT_TX_DONE) :
+            frsky_tx_on_air = 0;
+            break;
+
+        case (CC2500_EVENT_RX_ERROR) :
+            // the clone loop restarts rx, tx flushes before the next slot
+            frsky_clone_rx_error = 1;
+            break;
+
+        default:
+            // sync, tx done and rx errors need no action,
+            // the rx fifo is flushed before the next tx slot
+            break;
+    }
+}
+
+static void frsky_process_telemetry(const uint8_t *packet) {
+    if (!FRSKY_VALID_PACKET(packet)) {
+        return;
+    }
+
+    // rssi as seen by the receiver
+    frsky_rssi = packet[5];
+    // rssi of the telemetry packet as seen by us
+    frsky_rssi_telemetry = frsky_extract_rssi(packet[FRSKY_PACKET_BUFFER_SIZE - 2]);
+
+    // lqi is 0 for the best link
+    uint8_t lqi = packet[FRSKY_PACKET_BUFFER_SIZE - 1] & 0x7F;
+    if (frsky_rx_pending) {
+        frsky_rx_pending = 0;
+        linkstats_add_packet(frsky_rx_hop_index, frsky_rssi_telemetry, frsky_rssi, lqi);
+    }
+
+    // make the link visible to the telemetry readers as well
+    telemetry_set_value(TELEMETRY_VALUE_RSSI, frsky_rssi);
+    telemetry_set_value(TELEMETRY_VALUE_LQI, lqi);
+
+    // track the crystal drift of both sides
+    frsky_afc_update(cc2500_get_rx_freq_estimate());
+
+    // hub telemetry payload
+    uint8_t hub_len = min(packet[6], FRSKY_PACKET_BUFFER_SIZE - 2 - 8);
+    telemetry_enqueue_block(&packet[8], hub_len);
+}
+
 void frsky_send_bindpacket(uint8_t bind_packet_id) {
-    (void) bind_packet_id;
+    // called from the slot isr with the slot chain idle
+    cc2500_chain_t *chain = &frsky_slot_chain;
+    cc2500_chain_reset(chain);
+
+    if (bind_packet_id == 0) {
+        // channel 0 is not part of the calibration cache
+        cc2500_chain_register(chain, MCSM0, FRSKY_MCSM0_AUTOCAL);
+    }
+
+    // bind packets are always sent on channel 0
+    cc2500_chain_strobe(chain, RFST_SIDLE);
+    cc2500_chain_register(chain, CHANNR, 0);
+
+    // without a buffer the next slot tries again
+    packet_buffer_t *tx = packet_pool_alloc(PACKET_OWNER_BUILDER);
+    if (tx) {
+        frsky_build_bindpacket(tx->data, bind_packet_id);
+        frsky_chain_packet(chain, tx);
+    }
+
+    frsky_slot_chain_start();
 }
 
 uint8_t frsky_bind_jumper_set(void) {
@@ -125,6 +844,10 @@ uint8_t frsky_bind_jumper_set(void) {
 void frsky_do_clone_prepare(void) {
     debug("frsky: do clone\n"); debug_flush();
 
+    // bind packets are handled by the packet isr from now on
+    frsky_clone_capture = 0;
+    frsky_clone_active  = 1;
+
     // set up leds:
     led_button_r_off();
     led_button_l_on();
@@ -136,9 +859,15 @@ void frsky_enter_bindmode(void) {
     // set up leds:
     led_button_r_on();
     led_button_l_off();
+
+    // the isr will send bind packets from now on
+    frsky_bind_packet_id = 0;
+    frsky_bind_mode = 1;
 }
 
 void frsky_do_clone_finish(void) {
+    frsky_clone_active = 0;
+
     // save to persistant storage:
     storage_save();
 
@@ -153,52 +882,240 @@ void frsky_autotune_prepare(void) {
     debug("frsky: entering bind loop\n"); debug_flush();
 
     led_button_r_off();
+
+    frsky_autotune_state      = FRSKY_AUTOTUNE_STATE_COARSE;
+    frsky_autotune_offset     = FRSKY_AUTOTUNE_COARSE_MIN;
+    frsky_autotune_best       = 0;
+    frsky_autotune_best_score = 0;
+    frsky_autotune_step       = FRSKY_AUTOTUNE_COARSE_STEP / 2;
 }
 
 uint32_t frsky_autotune_do(void) {
-    // search for best fscal 0 match
+    uint16_t score;
+    int8_t center;
+
     // reset wdt
     wdt_reset();
 
-    return 1;
+    if (frsky_autotune_state == FRSKY_AUTOTUNE_STATE_COARSE) {
+        // coarse sweep, one offset per call
+        score = frsky_autotune_score(frsky_autotune_offset);
+        if (score > frsky_autotune_best_score) {
+            frsky_autotune_best_score = score;
+            frsky_autotune_best       = frsky_autotune_offset;
+        }
+
+        if (frsky_autotune_offset < FRSKY_AUTOTUNE_COARSE_MAX) {
+            frsky_autotune_offset += FRSKY_AUTOTUNE_COARSE_STEP;
+            return 0;
+        }
+
+        // start over until we heard the tx at all
+        frsky_autotune_offset = FRSKY_AUTOTUNE_COARSE_MIN;
+        if (frsky_autotune_best_score) {
+            frsky_autotune_state = FRSKY_AUTOTUNE_STATE_FINE;
+        }
+        return 0;
+    }
+
+    // refinement, probe both neighbours of the best offset
+    center = frsky_autotune_best;
+
+    score = frsky_autotune_score(center - frsky_autotune_step);
+    if (score > frsky_autotune_best_score) {
+        frsky_autotune_best_score = score;
+        frsky_autotune_best       = center - frsky_autotune_step;
+    }
+
+    score = frsky_autotune_score(center + frsky_autotune_step);
+    if (score > frsky_autotune_best_score) {
+        frsky_autotune_best_score = score;
+        frsky_autotune_best       = center + frsky_autotune_step;
+    }
+
+    frsky_autotune_step /= 2;
+    return (frsky_autotune_step == 0);
 }
 
 
 void frsky_autotune_finish(void) {
+    debug("frsky: autotune offset 0x"); debug_put_hex8(frsky_autotune_best); debug_put_newline();
+    debug_flush();
+
+    // use the result and track drift from there
+    storage.frsky_freq_offset = frsky_autotune_best;
+    cc2500_strobe(RFST_SIDLE);
+    frsky_afc_reset();
+    cc2500_set_register(FSCTRL0, frsky_afc_offset);
+}
+
+static uint16_t frsky_autotune_score(int8_t offset) {
+    // every bind packet heard counts with its link quality
+    frsky_clone_listen(offset);
+    frsky_clone_wait(FRSKY_AUTOTUNE_WINDOW_MS);
+    return frsky_clone_quality;
+}
+
+static void frsky_clone_listen(int8_t offset) {
+    cc2500_strobe(RFST_SIDLE);
+    cc2500_set_register(FSCTRL0, offset);
+
+    // bind packets are sent on channel 0, calibrate on entering rx
+    cc2500_set_register(MCSM0, FRSKY_MCSM0_AUTOCAL);
+    frsky_tune_channel(0);
+
+    frsky_clone_quality  = 0;
+    frsky_clone_rx_error = 0;
+
+    cc2500_enter_rxmode();
+    cc2500_strobe(RFST_SFRX);
+    cc2500_strobe(RFST_SRX);
+}
+
+static void frsky_clone_wait(uint32_t ms) {
+    uint32_t start = timeout_get_ms();
+
+    while ((timeout_get_ms() - start) < ms) {
+        if (frsky_clone_rx_error) {
+            // fifo overflow or bad length, restart rx
+            frsky_clone_rx_error = 0;
+            cc2500_strobe(RFST_SIDLE);
+            cc2500_strobe(RFST_SFRX);
+            cc2500_strobe(RFST_SRX);
+        }
+    }
+}
+
+static void frsky_clone_process_packet(const uint8_t *packet) {
+    uint8_t i, idx;
+
+    if (!FRSKY_VALID_PACKET_BIND(packet)) {
+        return;
+    }
+
+    // lqi is 0 for the best link
+    frsky_clone_quality += 0x80 - (packet[FRSKY_PACKET_BUFFER_SIZE - 1] & 0x7F);
+
+    if (!frsky_clone_capture) {
+        return;
+    }
+
+    // stick to the first tx we hear
+    if (frsky_clone_hop_valid == 0) {
+        frsky_clone_txid[0] = packet[3];
+        frsky_clone_txid[1] = packet[4];
+    } else if ((packet[3] != frsky_clone_txid[0]) || (packet[4] != frsky_clone_txid[1])) {
+        return;
+    }
+
+    // each bind packet carries five hop table entries
+    idx = packet[5];
+    for (i = 0; i < FRSKY_BINDPACKET_HOPS; i++) {
+        if ((idx + i) < FRSKY_HOPTABLE_SIZE) {
+            frsky_clone_hop_table[idx + i] = packet[6 + i];
+            frsky_clone_hop_valid |= (1ULL << (idx + i));
+        }
+    }
 }
 
 
 void frsky_enter_rxmode(uint8_t channel) {
-    (void) channel;
+    // switch antenna path to rx
+    cc2500_enter_rxmode();
+
+    // hop and start receiving
+    frsky_set_channel(channel);
+    cc2500_strobe(RFST_SFRX);
+    cc2500_strobe(RFST_SRX);
 }
 
 
 void frsky_tune_channel(uint8_t ch) {
-    (void) ch;
+    // go to idle and set the raw channel number
+    cc2500_strobe(RFST_SIDLE);
+    cc2500_set_register(CHANNR, ch);
 }
 
 void frsky_fetch_txid_and_hoptable_prepare(void) {
+    debug("frsky: fetch hoptable\n"); debug_flush();
+
+    // listen on the tuned offset and collect the hop table
+    frsky_clone_hop_valid = 0;
+    frsky_clone_capture   = 1;
+    frsky_clone_listen(storage.frsky_freq_offset);
 }
 
 uint32_t frsky_fetch_txid_and_hoptable_do(void) {
     // fetch hopdata array
     // reset wdt
     wdt_reset();
-    return 1;
+
+    frsky_clone_wait(FRSKY_HOPTABLE_WINDOW_MS);
+
+    // done as soon as every entry was seen once
+    return (frsky_clone_hop_valid == ((1ULL << FRSKY_HOPTABLE_SIZE) - 1));
 }
 
 void frsky_fetch_txid_and_hoptable_finish(void) {
+    uint32_t i;
+
+    frsky_clone_capture = 0;
+    cc2500_strobe(RFST_SIDLE);
+
+    storage.frsky_txid[0] = frsky_clone_txid[0];
+    storage.frsky_txid[1] = frsky_clone_txid[1];
+    for (i = 0; i < FRSKY_HOPTABLE_SIZE; i++) {
+        storage.frsky_hop_table[i] = frsky_clone_hop_table[i];
+    }
+
+    debug("frsky: txid 0x"); debug_put_hex8(storage.frsky_txid[0]);
+    debug_put_hex8(storage.frsky_txid[1]); debug_put_newline();
+    debug_flush();
 }
 
 void frsky_calib_pll(void) {
+    uint32_t i;
+    uint32_t timeout;
+
+    debug("frsky: calib pll\n"); debug_flush();
+
+    // calibrate on every idle -> rx/tx transition while we are busy
+    cc2500_set_register(MCSM0, FRSKY_MCSM0_AUTOCAL);
+
+    // fill the calibration table for all hop channels
+    for (i = 0; i < FRSKY_HOPTABLE_SIZE; i++) {
+        frsky_tune_channel(storage.frsky_hop_table[i]);
+
+        // start calibration and wait for it to finish (takes ~720us)
+        cc2500_strobe(RFST_SCAL);
+        for (timeout = 0; timeout < 100; timeout++) {
+            delay_us(20);
+            if ((cc2500_get_register(MARCSTATE) & 0x1F) == 0x01) break;
+        }
+
+        cc2500_fscal_save(frsky_calib_table[i]);
+    }
+
+    // from now on hops load the cached values
+    cc2500_set_register(MCSM0, FRSKY_MCSM0_MANUALCAL);
+
+    debug("frsky: calib pll done\n"); debug_flush();
 }
 
 void frsky_set_channel(uint8_t hop_index) {
-    (void) hop_index;
+    // load cached pll calibration and tune to the hop channel
+    frsky_tune_channel(storage.frsky_hop_table[hop_index]);
+    cc2500_fscal_load(frsky_calib_table[hop_index]);
 }
 
 void frsky_increment_channel(int8_t cnt) {
-    (void) cnt;
+    int16_t next = (int16_t)frsky_counter + cnt;
+
+    // wrap around in both directions
+    while (next < 0) next += FRSKY_COUNTER_MAX;
+    frsky_counter = next % FRSKY_COUNTER_MAX;
+
+    frsky_set_channel(frsky_counter % FRSKY_HOPTABLE_SIZE);
 }
 
 uint8_t frsky_extract_rssi(uint8_t rssi_raw) {
@@ -30,9 +30,29 @@
 #define FRSKY_PACKET_BUFFER_SIZE (FRSKY_PACKET_LENGTH+3)
 #define FRSKY_COUNT_RXSTATS 20
 
+// frame rate modes. the receiver has to run the matching profile:
+// it hops with the same slot time and, without telemetry, expects
+// channel data in every slot instead of sending a reply in the 4th
+#define FRSKY_RATE_STANDARD          0  // 9ms slots, telemetry (stock d8)
+#define FRSKY_RATE_FAST              1  // 4.5ms slots, telemetry
+#define FRSKY_RATE_FAST_NOTELEMETRY  2  // 4.5ms slots, data only
+#define FRSKY_RATE_COUNT             3
+
+// slots that ran out of their time budget
+typedef struct {
+    // slot isr still busy when the next slot was due
+    uint16_t isr;
+    // spi upload of the last packet not finished
+    uint16_t upload;
+    // last packet still on air
+    uint16_t air;
+} frsky_overruns_t;
+
 void frsky_init(void);
 uint8_t frsky_check_transceiver(void);
+uint8_t frsky_is_fitted(void);
 void frsky_configure(void);
+void frsky_resume(void);
 uint8_t frsky_bind_jumper_set(void);
 void frsky_enter_bindmode(void);
 void frsky_configure_address(void);
@@ -44,6 +64,7 @@ void frsky_fetch_txid_and_hoptable(void);
 void frsky_calib_pll(void);
 // void frsky_main(void);
 void frsky_handle_telemetry(void);
+uint32_t frsky_afc_store(void);
 
 uint8_t frsky_extract_rssi(uint8_t rssi_raw);
 void frsky_increment_channel(int8_t cnt);
@@ -65,17 +86,21 @@ void frsky_fetch_txid_and_hoptable_finish(void);
 void frsky_init_timer(void);
 
 void frsky_get_rssi(uint8_t *rssi, uint8_t *rssi_telemetry);
+void frsky_get_slot_timing(uint16_t *last_us, uint16_t *max_us);
+
+void frsky_set_rate(uint8_t rate);
+uint8_t frsky_get_rate(void);
+char *frsky_get_rate_name(uint8_t rate);
+uint16_t frsky_get_slot_period_us(void);
+uint16_t frsky_get_rx_window_us(void);
+void frsky_get_overruns(frsky_overruns_t *overruns);
+void frsky_reset_overruns(void);
 
 // extern uint8_t frsky_current_ch_idx;
 // extern uint8_t frsky_diversity_count;
 // rssi
 // extern uint8_t frsky_rssi;
 // extern uint8_t frsky_link_quality;
-// pll calibration
-// extern uint8_t frsky_calib_fscal1_table[FRSKY_HOPTABLE_SIZE];
-// extern uint8_t frsky_calib_fscal2;
-// extern uint8_t frsky_calib_fscal3;
-//
 // extern volatile uint8_t frsky_packet_buffer[FRSKY_PACKET_BUFFER_SIZE];
 // extern volatile uint8_t frsky_packet_received;
 // extern volatile uint8_t frsky_packet_sent;
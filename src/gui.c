@@ -28,6 +28,14 @@
 #include "io.h"
 #include "storage.h"
 #include "telemetry.h"
+#include "linkstats.h"
+#include "history.h"
+#include "shaping.h"
+#include "mixer.h"
+#include "scanner.h"
+#include "cc2500.h"
+#include "radio.h"
+#include "packet_pool.h"
 #include "wdt.h"
 #include "adc.h"
 #include "sound.h"
@@ -35,6 +43,7 @@
 #include "touch.h"
 #include "screen.h"
 #include "assert.h"
+#include "protocol/common.h"
 
 static uint32_t gui_config_counter;
 static uint32_t gui_shutdown_pressed;
@@ -46,6 +55,15 @@ static uint8_t gui_touch_callback_index;
 static touch_callback_entry_t gui_touch_callback[GUI_TOUCH_CALLBACK_COUNT];
 static int16_t gui_model_timer;
 static uint8_t gui_loop_counter;
+// telemetry values shown on the main screen, refreshed from the store
+// only for sensors that changed since the last frame
+static int32_t gui_telemetry_voltage;
+static int32_t gui_telemetry_current;
+static int32_t gui_telemetry_mah;
+static uint8_t gui_history_sensor;
+// the history page shows the per hop link quality after the recorded sensors
+#define GUI_HISTORY_VIEW_LINK HISTORY_SENSOR_COUNT
+static uint8_t gui_shaping_channel;
 
 // internal functions
 static void gui_touch_callback_register(uint8_t xs, uint8_t xe, uint8_t ys, uint8_t ye, f_ptr_t cb);
@@ -69,6 +87,27 @@ static void gui_cb_model_timer_reload(void);
 static void gui_cb_model_prev(void);
 static void gui_cb_model_next(void);
 static void gui_cb_setting_model_stickscale(void);
+static void gui_cb_setting_model_rate(void);
+static void gui_cb_model_rate_dec(void);
+static void gui_cb_model_rate_inc(void);
+static void gui_cb_model_lead_dec(void);
+static void gui_cb_model_lead_inc(void);
+static void gui_cb_render_option_lead(uint32_t UNUSED(x), uint32_t y);
+static void gui_cb_setting_model_lead(void);
+static void gui_cb_setting_model_a7105(void);
+static void gui_cb_model_a7105_dec(void);
+static void gui_cb_model_a7105_inc(void);
+static void gui_cb_render_option_a7105(uint32_t UNUSED(x), uint32_t y);
+static void gui_cb_render_option_rate(uint32_t x, uint32_t y);
+static void gui_cb_setting_model_expo(void);
+static void gui_cb_setting_model_deadband(void);
+static void gui_cb_model_expo_dec(void);
+static void gui_cb_model_expo_inc(void);
+static void gui_cb_model_deadband_dec(void);
+static void gui_cb_model_deadband_inc(void);
+static void gui_cb_model_shaping_channel(void);
+static void gui_cb_render_option_expo(uint32_t UNUSED(x), uint32_t y);
+static void gui_cb_render_option_deadband(uint32_t UNUSED(x), uint32_t y);
 static void gui_cb_setting_model_name(void);
 static void gui_cb_setting_model_timer(void);
 static void gui_cb_setting_option_leave(void);
@@ -81,10 +120,16 @@ static void gui_cb_config_model(void);
 static void gui_cb_config_exit(void);
 static void gui_cb_setup_clonetx(void);
 static void gui_cb_setup_bootloader(void);
+static void gui_cb_setup_scanner(void);
+static void gui_cb_setup_scanner_exit(void);
+static void gui_cb_setup_stats(void);
 static void gui_cb_setup_exit(void);
+static void gui_cb_history_next_sensor(void);
 
 // rendering
 static void gui_render_main_screen(void);
+static void gui_update_telemetry(void);
+static uint32_t gui_telemetry_color(uint8_t index);
 static void gui_render(void);
 static void gui_render_usb(void);
 static void gui_render_sliders(void);
@@ -92,12 +137,18 @@ static void gui_render_battery(void);
 static void gui_render_statusbar(void);
 static void gui_render_bottombar(void);
 static void gui_render_settings(void);
+static void gui_render_history(void);
+static void gui_render_history_link(void);
 static void gui_render_rssi(void);
 static void gui_config_main_render(void);
 static void gui_config_model_render(void);
 static void gui_setup_clonetx_render(void);
 static void gui_setup_bindmode_render(void);
 static void gui_setup_bootloader_render(void);
+static void gui_setup_scanner_render(void);
+static void gui_setup_stats_render(void);
+static void gui_render_histogram(uint8_t x, uint8_t y, const uint16_t *hist, uint8_t count);
+static void gui_put_count(uint8_t x, uint8_t y, uint32_t value);
 
 // buttons
 static void gui_handle_button_powerdown(void);
@@ -111,6 +162,11 @@ void gui_init(void) {
     gui_shutdown_pressed = 0;
     gui_config_tap_detected = 0;
     gui_touch_callback_index = 0;
+    gui_telemetry_voltage = 0;
+    gui_telemetry_current = 0;
+    gui_telemetry_mah = 0;
+    gui_history_sensor = HISTORY_SENSOR_VOLTAGE;
+    gui_shaping_channel = CHANNEL_ID_AILERON;
 
     gui_touch_callback_clear();
 }
@@ -219,18 +275,31 @@ static void gui_process_touch(void) {
 
 static void gui_cb_model_timer_reload(void) {
     gui_model_timer = (int16_t) storage.model[storage.current_model].timer;
+    // a timer reload starts a new flight
+    history_reset();
+}
+
+static void gui_cb_history_next_sensor(void) {
+    // the per hop link view follows the recorded sensors
+    gui_history_sensor = (gui_history_sensor + 1) % (GUI_HISTORY_VIEW_LINK + 1);
 }
 
 static void gui_cb_model_prev(void) {
     if (storage.current_model > 0) {
         storage.current_model--;
     }
+    frsky_set_rate(storage.model[storage.current_model].frsky_rate);
+    mixer_compile();
+    radio_a7105_select(storage.model[storage.current_model].a7105_protocol);
 }
 
 static void gui_cb_model_next(void) {
     if (storage.current_model < (STORAGE_MODEL_MAX_COUNT-1)) {
         storage.current_model++;
     }
+    frsky_set_rate(storage.model[storage.current_model].frsky_rate);
+    mixer_compile();
+    radio_a7105_select(storage.model[storage.current_model].a7105_protocol);
 }
 
 static void gui_cb_setting_model_stickscale(void) {
@@ -238,6 +307,31 @@ static void gui_cb_setting_model_stickscale(void) {
     gui_sub_page = GUI_SUBPAGE_SETTING_MODEL_SCALE;
 }
 
+static void gui_cb_setting_model_rate(void) {
+    gui_page    |= GUI_PAGE_CONFIG_OPTION_FLAG;
+    gui_sub_page = GUI_SUBPAGE_SETTING_MODEL_RATE;
+}
+
+static void gui_cb_setting_model_lead(void) {
+    gui_page    |= GUI_PAGE_CONFIG_OPTION_FLAG;
+    gui_sub_page = GUI_SUBPAGE_SETTING_MODEL_LEAD;
+}
+
+static void gui_cb_setting_model_a7105(void) {
+    gui_page    |= GUI_PAGE_CONFIG_OPTION_FLAG;
+    gui_sub_page = GUI_SUBPAGE_SETTING_MODEL_A7105;
+}
+
+static void gui_cb_setting_model_expo(void) {
+    gui_page    |= GUI_PAGE_CONFIG_OPTION_FLAG;
+    gui_sub_page = GUI_SUBPAGE_SETTING_MODEL_EXPO;
+}
+
+static void gui_cb_setting_model_deadband(void) {
+    gui_page    |= GUI_PAGE_CONFIG_OPTION_FLAG;
+    gui_sub_page = GUI_SUBPAGE_SETTING_MODEL_DBAND;
+}
+
 static void gui_cb_setting_model_name(void) {
     gui_page    |= GUI_PAGE_CONFIG_OPTION_FLAG;
     gui_sub_page = GUI_SUBPAGE_SETTING_MODEL_NAME;
@@ -264,6 +358,89 @@ static void gui_cb_model_stickscale_inc(void) {
     }
 }
 
+static void gui_cb_model_rate_dec(void) {
+    if (storage.model[storage.current_model].frsky_rate > 0) {
+        storage.model[storage.current_model].frsky_rate--;
+    }
+    frsky_set_rate(storage.model[storage.current_model].frsky_rate);
+}
+
+static void gui_cb_model_rate_inc(void) {
+    if (storage.model[storage.current_model].frsky_rate < (FRSKY_RATE_COUNT-1)) {
+        storage.model[storage.current_model].frsky_rate++;
+    }
+    frsky_set_rate(storage.model[storage.current_model].frsky_rate);
+}
+
+static void gui_cb_model_lead_dec(void) {
+    if (storage.model[storage.current_model].mixer_lead > 0) {
+        storage.model[storage.current_model].mixer_lead--;
+    }
+    mixer_set_lead_time(storage.model[storage.current_model].mixer_lead * MIXER_LEAD_TIME_STEP_US);
+}
+
+static void gui_cb_model_lead_inc(void) {
+    if (storage.model[storage.current_model].mixer_lead <
+        (MIXER_LEAD_TIME_MAX_US / MIXER_LEAD_TIME_STEP_US)) {
+        storage.model[storage.current_model].mixer_lead++;
+    }
+    mixer_set_lead_time(storage.model[storage.current_model].mixer_lead * MIXER_LEAD_TIME_STEP_US);
+}
+
+static void gui_cb_model_a7105_dec(void) {
+    if (storage.model[storage.current_model].a7105_protocol > PROTOCOL_NONE) {
+        storage.model[storage.current_model].a7105_protocol--;
+    }
+    radio_a7105_select(storage.model[storage.current_model].a7105_protocol);
+}
+
+static void gui_cb_model_a7105_inc(void) {
+    if (storage.model[storage.current_model].a7105_protocol < (PROTOCOL_COUNT-1)) {
+        storage.model[storage.current_model].a7105_protocol++;
+    }
+    radio_a7105_select(storage.model[storage.current_model].a7105_protocol);
+}
+
+static void gui_cb_model_expo_dec(void) {
+    MODEL_SHAPING_DESC *shaping =
+            &storage.model[storage.current_model].shaping[gui_shaping_channel];
+    if (shaping->expo > 0) {
+        shaping->expo--;
+    }
+    shaping_compile();
+}
+
+static void gui_cb_model_expo_inc(void) {
+    MODEL_SHAPING_DESC *shaping =
+            &storage.model[storage.current_model].shaping[gui_shaping_channel];
+    if (shaping->expo < 100) {
+        shaping->expo++;
+    }
+    shaping_compile();
+}
+
+static void gui_cb_model_deadband_dec(void) {
+    MODEL_SHAPING_DESC *shaping =
+            &storage.model[storage.current_model].shaping[gui_shaping_channel];
+    if (shaping->deadband > 0) {
+        shaping->deadband--;
+    }
+    shaping_compile();
+}
+
+static void gui_cb_model_deadband_inc(void) {
+    MODEL_SHAPING_DESC *shaping =
+            &storage.model[storage.current_model].shaping[gui_shaping_channel];
+    if (shaping->deadband < 50) {
+        shaping->deadband++;
+    }
+    shaping_compile();
+}
+
+static void gui_cb_model_shaping_channel(void) {
+    gui_shaping_channel = (gui_shaping_channel + 1) % STORAGE_SHAPING_COUNT;
+}
+
 static void gui_cb_model_timer_dec(void) {
     if (storage.model[storage.current_model].timer > 2) {
         storage.model[storage.current_model].timer--;
@@ -293,6 +470,7 @@ static void gui_cb_config_back(void) {
 }
 
 static void gui_cb_config_save(void) {
+    frsky_afc_store();
     storage_save();
     gui_cb_config_back();
 }
@@ -315,12 +493,19 @@ static void gui_cb_config_model(void) {
 }
 
 static void gui_cb_setup_clonetx(void) {
+    if (!frsky_is_fitted()) {
+        // these pages need the cc2500
+        return;
+    }
     // disable tx code
     frsky_tx_set_enabled(0);
     gui_page = GUI_PAGE_SETUP_CLONETX;
 }
 
 static void gui_cb_setup_bind(void) {
+    if (!frsky_is_fitted()) {
+        return;
+    }
     gui_page = GUI_PAGE_SETUP_BIND;
 }
 
@@ -330,6 +515,25 @@ static void gui_cb_setup_bootloader(void) {
     gui_page = GUI_PAGE_SETUP_BOOTLOADER;
 }
 
+static void gui_cb_setup_scanner(void) {
+    if (!frsky_is_fitted()) {
+        return;
+    }
+    // disable tx code, the scanner takes over the cc2500
+    frsky_tx_set_enabled(0);
+    gui_page = GUI_PAGE_SETUP_SCANNER;
+}
+
+static void gui_cb_setup_scanner_exit(void) {
+    // restart tx code
+    scanner_stop();
+    gui_page = GUI_PAGE_SETUP_MAIN;
+}
+
+static void gui_cb_setup_stats(void) {
+    gui_page = GUI_PAGE_SETUP_STATS;
+}
+
 static void gui_cb_config_enter(void) {
     gui_page = GUI_PAGE_CONFIG_MAIN;
 }
@@ -343,6 +547,8 @@ static void gui_cb_setup_exit(void) {
 static void gui_cb_config_exit(void) {
     // restore old settings
     storage_load();
+    frsky_set_rate(storage.model[storage.current_model].frsky_rate);
+    mixer_compile();
 
     // back to config main menu
     gui_page = GUI_PAGE_CONFIG_MAIN;
@@ -389,6 +595,8 @@ static void gui_process_logic(void) {
         second_elapsed = 1;
         // next timeout in 1s
         timeout2_set_100us(10000);
+        // the a7105 protocol has to fit next to frsky with measured runtimes
+        radio_a7105_check();
     }
 
     // count down when
@@ -469,6 +677,8 @@ void gui_loop(void) {
             // do some processing instead of wasting cpu cycles
             frsky_handle_telemetry();
 
+            history_update();
+
             usb_handle_data();
         }
 
@@ -477,6 +687,14 @@ void gui_loop(void) {
     }
 
     debug("will power down now\n"); debug_flush();
+
+    // keep a converged frequency offset, stop rf before writing the flash
+    frsky_tx_set_enabled(0);
+    radio_a7105_stop();
+    if (frsky_afc_store()) {
+        storage_save();
+    }
+
     led_backlight_off();
     lcd_powerdown();
     io_powerdown();
@@ -523,12 +741,12 @@ static void gui_render_rssi(void) {
     // render rx rssi bargraph at a given position
     screen_fill_rect(x, 1, GUI_RSSI_BAR_W+1, 5, 0);
     x+=GUI_RSSI_BAR_W+2;
-    // show values
-    screen_puts_xy(x, 1, 0, "120|105");
 
-    // show RSSI
-    uint8_t rssi, rssi_telemetry;
-    frsky_get_rssi(&rssi, &rssi_telemetry);
+    // show averaged RSSI of the recent telemetry packets
+    linkstats_t stats;
+    linkstats_get(&stats);
+    uint8_t rssi = stats.rssi_rx;
+    uint8_t rssi_telemetry = stats.rssi;
 
     screen_put_uint8(x, 1, 0, rssi_telemetry);
     x += (GUI_STATUSBAR_FONT[FONT_FIXED_WIDTH]+1) * 3;
@@ -541,8 +759,8 @@ static void gui_render_rssi(void) {
     screen_fill_rect(x, 1, GUI_RSSI_BAR_W+1, 5, 0);
 
     // fill bargraphs
-    // rssi can be 0..100 (?)
-    uint8_t bar_w = min(rssi_telemetry, 100)/4;
+    // left: link quality 0..100%, right: rssi can be 0..100 (?)
+    uint8_t bar_w = min(stats.quality, 100)/4;
     if (bar_w > 1) bar_w--;
     if (bar_w > 0) screen_fill_rect(1+bar_w, 2, 25-bar_w, 3, 1);
     bar_w = min(rssi, 100)/4;
@@ -650,6 +868,11 @@ void gui_render(void) {
             gui_render_sliders();
             break;
 
+        case (GUI_PAGE_HISTORY) :
+            // telemetry history graphs
+            gui_render_history();
+            break;
+
         case (GUI_PAGE_SETTINGS) :
             // setup and config screen
             gui_render_settings();
@@ -658,6 +881,112 @@ void gui_render(void) {
     screen_update();
 }
 
+static void gui_render_history(void) {
+    #define GUI_HISTORY_X      16
+    #define GUI_HISTORY_TOP_Y  15
+    #define GUI_HISTORY_BASE_Y (LCD_HEIGHT - 8)
+    #define GUI_HISTORY_H      (GUI_HISTORY_BASE_Y - GUI_HISTORY_TOP_Y)
+    uint32_t i, h, w;
+    uint32_t x, y, y_prev;
+    int32_t range_min, range_max, range;
+    history_bucket_t bucket;
+    uint8_t count = history_get_count();
+
+    if (gui_history_sensor == GUI_HISTORY_VIEW_LINK) {
+        gui_render_history_link();
+        return;
+    }
+
+    gui_render_statusbar();
+
+    screen_set_font(font_tomthumb3x5, &h, &w);
+    screen_puts_xy(GUI_HISTORY_X, 9, 1, (char *)history_get_sensor_name(gui_history_sensor));
+
+    // scale the graph to the recorded range, empty buckets do not widen it
+    range_min = INT16_MAX;
+    range_max = INT16_MIN;
+    for (i = 0; i < count; i++) {
+        history_get_bucket(gui_history_sensor, i, &bucket);
+        range_min = min(range_min, bucket.min);
+        range_max = max(range_max, bucket.max);
+    }
+    if (range_min > range_max) {
+        // nothing recorded yet
+        range_min = 0;
+        range_max = 0;
+    }
+    range = max(1, range_max - range_min);
+
+    // axis labels: range and the time covered by one bucket
+    screen_put_uint14(LCD_WIDTH - GUI_HISTORY_X - 5*w, 9, 1, max(0, range_max));
+    screen_put_uint14(LCD_WIDTH - GUI_HISTORY_X - 5*w, GUI_HISTORY_BASE_Y + 2, 1, max(0, range_min));
+    screen_put_uint14(GUI_HISTORY_X, GUI_HISTORY_BASE_Y + 2, 1,
+                      min(history_get_bucket_ms() / 1000, 9999));
+    screen_puts_xy(GUI_HISTORY_X + 5*w, GUI_HISTORY_BASE_Y + 2, 1, "S/PX");
+
+    screen_draw_hline(GUI_HISTORY_X, GUI_HISTORY_BASE_Y, 2 * HISTORY_BUCKET_COUNT, 1);
+
+    // min/max envelope as vertical bars, the average as a line.
+    // gaps where the sensor was stale stay empty
+    y_prev = 0;
+    for (i = 0; i < count; i++) {
+        history_get_bucket(gui_history_sensor, i, &bucket);
+        if (HISTORY_BUCKET_EMPTY(&bucket)) {
+            y_prev = 0;
+            continue;
+        }
+        x = GUI_HISTORY_X + 2*i;
+
+        uint32_t y_min = GUI_HISTORY_BASE_Y - ((bucket.min - range_min) * GUI_HISTORY_H) / range;
+        uint32_t y_max = GUI_HISTORY_BASE_Y - ((bucket.max - range_min) * GUI_HISTORY_H) / range;
+        screen_draw_vline(x, y_max, y_min - y_max + 1, 1);
+
+        y = GUI_HISTORY_BASE_Y - ((bucket.avg - range_min) * GUI_HISTORY_H) / range;
+        if (y_prev) {
+            screen_draw_line(x - 2, y_prev, x, y, 1);
+        }
+        y_prev = y;
+    }
+
+    // touch the graph to show the next sensor
+    gui_touch_callback_register(GUI_PREV_CLICK_X, GUI_NEXT_CLICK_X, 8, LCD_HEIGHT,
+                                &gui_cb_history_next_sensor);
+}
+
+static void gui_render_history_link(void) {
+    uint32_t i, h, w;
+    uint32_t x, bar;
+    linkstats_t stats;
+
+    gui_render_statusbar();
+
+    screen_set_font(font_tomthumb3x5, &h, &w);
+    screen_puts_xy(GUI_HISTORY_X, 9, 1, "LINK/HOP");
+
+    screen_put_uint14(LCD_WIDTH - GUI_HISTORY_X - 5*w, 9, 1, 100);
+    screen_put_uint14(LCD_WIDTH - GUI_HISTORY_X - 5*w, GUI_HISTORY_BASE_Y + 2, 1, 0);
+    screen_puts_xy(GUI_HISTORY_X, GUI_HISTORY_BASE_Y + 2, 1, "% PER HOP");
+
+    screen_draw_hline(GUI_HISTORY_X, GUI_HISTORY_BASE_Y, 2 * LINKSTATS_CHANNEL_COUNT, 1);
+
+    // telemetry packets received per hop index, a weak channel stands out
+    for (i = 0; i < LINKSTATS_CHANNEL_COUNT; i++) {
+        linkstats_get_channel(i, &stats);
+        if ((stats.received + stats.lost) == 0) {
+            // no telemetry slot on this hop yet
+            continue;
+        }
+        x   = GUI_HISTORY_X + 2*i;
+        bar = (stats.quality * GUI_HISTORY_H) / 100;
+        if (bar) {
+            screen_draw_vline(x, GUI_HISTORY_BASE_Y - bar, bar, 1);
+        }
+    }
+
+    gui_touch_callback_register(GUI_PREV_CLICK_X, GUI_NEXT_CLICK_X, 8, LCD_HEIGHT,
+                                &gui_cb_history_next_sensor);
+}
+
 static void gui_render_settings(void) {
     screen_set_font(font_tomthumb3x5, 0, 0);
 
@@ -719,6 +1048,16 @@ static void gui_setup_render(void) {
             gui_setup_bootloader_render();
             break;
 
+        case (GUI_PAGE_SETUP_SCANNER) :
+            // spectrum scanner
+            gui_setup_scanner_render();
+            break;
+
+        case (GUI_PAGE_SETUP_STATS) :
+            // runtime statistics
+            gui_setup_stats_render();
+            break;
+
         default:
             // invalid, go back
             gui_page = GUI_PAGE_SETTINGS;
@@ -738,6 +1077,29 @@ static void gui_config_header_render(char *str) {
     screen_puts_centered(h/2, 0, str);
 }
 
+static void gui_update_telemetry(void) {
+    uint32_t dirty = telemetry_get_dirty(TELEMETRY_READER_GUI);
+
+    // fetch only the sensors that were updated since the last frame
+    if (dirty & (1UL << TELEMETRY_VALUE_VOLTAGE)) {
+        gui_telemetry_voltage = telemetry_get_value(TELEMETRY_VALUE_VOLTAGE);
+    }
+    if (dirty & (1UL << TELEMETRY_VALUE_CURRENT)) {
+        gui_telemetry_current = telemetry_get_value(TELEMETRY_VALUE_CURRENT);
+    }
+    if (dirty & (1UL << TELEMETRY_VALUE_MAH)) {
+        gui_telemetry_mah = telemetry_get_value(TELEMETRY_VALUE_MAH);
+    }
+}
+
+static uint32_t gui_telemetry_color(uint8_t index) {
+    // stale values blink
+    if (telemetry_is_stale(index) && ((gui_loop_counter % 8) < 4)) {
+        return 0;
+    }
+    return 1;
+}
+
 static void gui_render_main_screen(void) {
     uint32_t x, y;
     uint32_t h, w;
@@ -746,24 +1108,28 @@ static void gui_render_main_screen(void) {
     gui_render_statusbar();
     gui_render_bottombar();
 
+    gui_update_telemetry();
+
     // render voltage
     screen_set_font(font_metric7x12, &h, &w);
     x = 1;
     y = 10;
-    screen_put_fixed2_1digit(x, y, 1, telemetry_get_voltage());
+    screen_put_fixed2_1digit(x, y, gui_telemetry_color(TELEMETRY_VALUE_VOLTAGE),
+                             gui_telemetry_voltage);
     x += w*3 + 3;
     screen_puts_xy(x, y, 1, "V");
 
     x = 1;
     y += h;
-    screen_put_fixed2_1digit(x, y, 1, telemetry_get_current());
+    screen_put_fixed2_1digit(x, y, gui_telemetry_color(TELEMETRY_VALUE_CURRENT),
+                             gui_telemetry_current);
     x += w*3 + 3;
     screen_puts_xy(x, y, 1, "A");
 
     x = LCD_WIDTH - (font_metric7x12[FONT_FIXED_WIDTH]+1)*7 - 1;
     y += h;
     y += 5;
-    screen_put_uint14(x, y, 1, telemetry_get_mah());
+    screen_put_uint14(x, y, gui_telemetry_color(TELEMETRY_VALUE_MAH), gui_telemetry_mah);
     x += w*4 + 1;
     screen_puts_xy(x, y, 1, "MAH");
 
@@ -826,6 +1192,8 @@ static void gui_setup_main_render(void) {
     gui_add_button_smallfont(3, 10 + 0*17, 50, 15, "BIND MODE", &gui_cb_setup_bind);
     gui_add_button_smallfont(3, 10 + 1*17, 50, 15, "CLONE  TX", &gui_cb_setup_clonetx);
     gui_add_button_smallfont(74, 10 + 0*17, 50, 15, "FW UPDATE", &gui_cb_setup_bootloader);
+    gui_add_button_smallfont(74, 10 + 1*17, 50, 15, "SCANNER", &gui_cb_setup_scanner);
+    gui_add_button_smallfont(3, 10 + 2*17, 50, 15, "STATS", &gui_cb_setup_stats);
 
     // exit button, go back to main
     gui_add_button_smallfont(74, 10 + 2*17, 50, 15, "EXIT", &gui_cb_setup_exit);
@@ -861,6 +1229,137 @@ static void gui_render_usb(void) {
     screen_update();
 }
 
+static void gui_setup_scanner_render(void) {
+    #define GUI_SCANNER_SWEEPS_PER_FRAME 2
+    #define GUI_SCANNER_BASE_Y (LCD_HEIGHT - 7)
+    #define GUI_SCANNER_BAR_H  (GUI_SCANNER_BASE_Y - 8)
+    uint32_t i, h, w;
+    uint8_t avg, peak;
+
+    if (gui_config_counter == 0) {
+        // calibrate all bins once
+        scanner_start();
+        gui_config_counter++;
+    }
+
+    // several sweeps per gui frame, the peak hold keeps short bursts
+    for (i = 0; i < GUI_SCANNER_SWEEPS_PER_FRAME; i++) {
+        scanner_sweep();
+    }
+
+    // header
+    gui_config_header_render("SCANNER");
+
+    // bar graph, average filled and peak as a dot on top
+    for (i = 0; i < SCANNER_BIN_COUNT; i++) {
+        avg  = (scanner_get_average(i) * GUI_SCANNER_BAR_H) / SCANNER_LEVEL_MAX;
+        peak = (scanner_get_peak(i) * GUI_SCANNER_BAR_H) / SCANNER_LEVEL_MAX;
+        if (avg) screen_fill_rect(i, GUI_SCANNER_BASE_Y - avg, 1, avg, 1);
+        screen_fill_rect(i, GUI_SCANNER_BASE_Y - peak, 1, 1, 1);
+    }
+
+    // axis
+    screen_set_font(font_tomthumb3x5, &h, &w);
+    screen_puts_xy(1, GUI_SCANNER_BASE_Y + 1, 1, "2404");
+    screen_puts_xy(LCD_WIDTH/2 - 2*w, GUI_SCANNER_BASE_Y + 1, 1, "2442");
+    screen_puts_xy(LCD_WIDTH - 1 - 4*w, GUI_SCANNER_BASE_Y + 1, 1, "2480");
+
+    // sweeps per second
+    uint16_t sweep_us = scanner_get_sweep_time_us();
+    if (sweep_us) {
+        gui_put_count(26, GUI_SCANNER_BASE_Y + 1, 1000000UL / sweep_us);
+        screen_puts_xy(26 + 4*w, GUI_SCANNER_BASE_Y + 1, 1, "/S");
+    }
+
+    // touch anywhere to leave
+    gui_touch_callback_register(0, LCD_WIDTH, 0, LCD_HEIGHT, &gui_cb_setup_scanner_exit);
+}
+
+static void gui_setup_stats_render(void) {
+    #define GUI_STATS_HIST_X 24
+    #define GUI_STATS_MAX_X  (GUI_STATS_HIST_X + CLOCK_HIST_BUCKETS * 4 + 4)
+    struct ClockStats clock;
+    uint8_t pool_free, pool_min_free;
+    uint16_t pool_failures;
+    uint32_t h, w;
+    uint8_t y;
+
+    screen_set_font(font_tomthumb3x5, &h, &w);
+
+    // header
+    gui_config_header_render("STATS");
+
+    // a7105 protocol callbacks: how late they start and how long they run,
+    // bucket n counts values below 16us << n
+    CLOCK_GetStats(&clock);
+    y = 9;
+    screen_puts_xy(3, y + 2, 1, "LATE");
+    gui_render_histogram(GUI_STATS_HIST_X, y, clock.late_hist, CLOCK_HIST_BUCKETS);
+    screen_puts_xy(GUI_STATS_MAX_X, y + 2, 1, "MAX");
+    gui_put_count(GUI_STATS_MAX_X + 4*w, y + 2, clock.late_max);
+    y += 9;
+    screen_puts_xy(3, y + 2, 1, "EXEC");
+    gui_render_histogram(GUI_STATS_HIST_X, y, clock.exec_hist, CLOCK_HIST_BUCKETS);
+    screen_puts_xy(GUI_STATS_MAX_X, y + 2, 1, "MAX");
+    gui_put_count(GUI_STATS_MAX_X + 4*w, y + 2, clock.exec_max);
+    y += 9;
+    screen_puts_xy(3, y, 1, "DEFER");
+    gui_put_count(3 + 6*w, y, clock.deferred);
+    screen_puts_xy(GUI_STATS_MAX_X, y, 1, "OVR");
+    gui_put_count(GUI_STATS_MAX_X + 4*w, y, clock.overruns);
+
+    // spi bytes per second the register shadows did not send
+    y += h + 3;
+    screen_puts_xy(3, y, 1, "SPI/S CC");
+    gui_put_count(3 + 9*w, y, cc2500_get_spi_bytes_saved_per_second());
+    screen_puts_xy(GUI_STATS_MAX_X, y, 1, "A7");
+    gui_put_count(GUI_STATS_MAX_X + 4*w, y, A7105_GetSpiBytesSavedPerSecond());
+
+    // packet buffers: free now, lowest seen and failed allocations
+    packet_pool_get_stats(&pool_free, &pool_min_free, &pool_failures);
+    y += h + 3;
+    screen_puts_xy(3, y, 1, "POOL");
+    gui_put_count(3 + 5*w, y, pool_free);
+    screen_puts_xy(44, y, 1, "MIN");
+    gui_put_count(44 + 4*w, y, pool_min_free);
+    screen_puts_xy(80, y, 1, "FAIL");
+    gui_put_count(80 + 5*w, y, pool_failures);
+
+    // telemetry bytes dropped because the fifo was full
+    y += h + 3;
+    screen_puts_xy(3, y, 1, "TLM OVF");
+    gui_put_count(3 + 8*w, y, telemetry_get_overflow_count());
+
+    // touch anywhere to leave
+    gui_touch_callback_register(0, LCD_WIDTH, 0, LCD_HEIGHT, &gui_cb_setup_enter);
+}
+
+static void gui_render_histogram(uint8_t x, uint8_t y, const uint16_t *hist, uint8_t count) {
+    #define GUI_HISTOGRAM_H 7
+    uint16_t max = 1;
+    uint8_t i, bar;
+
+    for (i = 0; i < count; i++) {
+        if (hist[i] > max) max = hist[i];
+    }
+
+    // one bar per bucket, scaled to the largest one. any hit shows a pixel
+    for (i = 0; i < count; i++) {
+        bar = ((uint32_t)hist[i] * GUI_HISTOGRAM_H) / max;
+        if (hist[i] && !bar) bar = 1;
+        screen_fill_rect(x + i*4, y + GUI_HISTOGRAM_H - 1, 3, 1, 1);
+        if (bar) screen_fill_rect(x + i*4, y + GUI_HISTOGRAM_H - bar, 3, bar, 1);
+    }
+}
+
+static void gui_put_count(uint8_t x, uint8_t y, uint32_t value) {
+    // four digits, larger counts are clipped
+    if (value > 9999) {
+        value = 9999;
+    }
+    screen_put_uint14(x, y, 1, value);
+}
+
 static void gui_setup_bootloader_render(void) {
     screen_set_font(font_tomthumb3x5, 0, 0);
 
@@ -890,12 +1389,12 @@ static void gui_setup_clonetx_render(void) {
     screen_puts_xy(3, 9 + 1*h, 1, "preparing bind...");
 
     if (gui_config_counter >= 1) screen_puts_xy(3, 9 + 2*h, 1, "preparing autotune");
-    if (gui_config_counter >= 2) screen_puts_xy(3, 9 + 3*h, 1, "autotune running (takes long)");
+    if (gui_config_counter >= 2) screen_puts_xy(3, 9 + 3*h, 1, "autotune running...");
     if (gui_config_counter >= 3) {
         screen_puts_xy(3, 9 + 4*h, 1, "autotune done. freq offset 0x");
         screen_put_hex16(3+w*29, 9 + 4*h, 1, storage.frsky_freq_offset);
     }
-    if (gui_config_counter >= 4) screen_puts_xy(3, 9 + 5*h, 1, "fetching hoptable (takes long)");
+    if (gui_config_counter >= 4) screen_puts_xy(3, 9 + 5*h, 1, "fetching hoptable...");
     if (gui_config_counter >= 6) {
         screen_puts_xy(3, 9 + 6*h, 1, "hoptable received. txid 0x");
         screen_put_hex16(3+w*26, 9 + 6*h, 1, storage.frsky_txid[0]);
@@ -1028,6 +1527,23 @@ static void gui_config_model_render_main(void) {
 
     // time
     gui_add_button_smallfont(3, y, 40, 13, "TIMER", &gui_cb_setting_model_timer);
+    y += 13 + 1;
+
+    // frame rate
+    gui_add_button_smallfont(3, y, 40, 13, "RATE", &gui_cb_setting_model_rate);
+
+    // mixer lead time
+    y -= 2 * (13 + 1);
+    gui_add_button_smallfont(46, y, 40, 13, "LEAD", &gui_cb_setting_model_lead);
+    y += 13 + 1;
+
+    // input shaping
+    gui_add_button_smallfont(46, y, 40, 13, "EXPO", &gui_cb_setting_model_expo);
+    y += 13 + 1;
+    gui_add_button_smallfont(46, y, 40, 13, "DBAND", &gui_cb_setting_model_deadband);
+
+    // second radio
+    gui_add_button_smallfont(89, 34 - 1*15, 35, 13, "A7105", &gui_cb_setting_model_a7105);
 
     // render buttons and set callback
     gui_add_button_smallfont(89, 34 + 0*15, 35, 13, "SAVE", &gui_cb_config_save);
@@ -1096,6 +1612,115 @@ static void gui_cb_render_option_timer(uint32_t UNUSED(x), uint32_t y) {
 }
 
 
+static void gui_cb_render_option_rate(uint32_t x, uint32_t y) {
+    uint8_t rate = storage.model[storage.current_model].frsky_rate;
+    frsky_overruns_t overruns;
+    uint16_t slot_us, slot_max_us;
+    uint32_t w;
+    screen_set_font(font_system5x7, 0, 0);
+
+    // render +/- button
+    gui_add_button(15, y, 15, 15, "-", &gui_cb_model_rate_dec);
+    gui_add_button(LCD_WIDTH - 15 - 15, y, 15, 15, "+", &gui_cb_model_rate_inc);
+
+    // render slot time, a trailing - marks the mode without telemetry
+    screen_puts_centered(y + 4, 1, frsky_get_rate_name(rate));
+
+    // slots that missed their budget: isr, spi upload and packet on air
+    frsky_get_overruns(&overruns);
+    screen_set_font(font_tomthumb3x5, 0, &w);
+    y += 15 + 2;
+    uint32_t ox = LCD_WIDTH / 2 - screen_strlen("ISR 1234 UPL 1234 AIR 1234") / 2;
+    screen_puts_xy(ox, y, 1, "ISR");
+    gui_put_count(ox + 4*w, y, overruns.isr);
+    screen_puts_xy(ox + 9*w, y, 1, "UPL");
+    gui_put_count(ox + 13*w, y, overruns.upload);
+    screen_puts_xy(ox + 18*w, y, 1, "AIR");
+    gui_put_count(ox + 22*w, y, overruns.air);
+
+    // worst slot isr runtime, next to the ok button
+    frsky_get_slot_timing(&slot_us, &slot_max_us);
+    y += 8;
+    screen_puts_xy(x + 2, y, 1, "SLOT US");
+    screen_puts_xy(LCD_WIDTH - x - 2 - 7*w, y, 1, "MAX");
+    gui_put_count(LCD_WIDTH - x - 2 - 4*w, y, slot_max_us);
+}
+
+static void gui_cb_render_option_lead(uint32_t UNUSED(x), uint32_t y) {
+    uint16_t last, max;
+    uint32_t w;
+    screen_set_font(font_system5x7, 0, &w);
+
+    // render +/- button
+    gui_add_button(15, y, 15, 15, "-", &gui_cb_model_lead_dec);
+    gui_add_button(LCD_WIDTH - 15 - 15, y, 15, 15, "+", &gui_cb_model_lead_inc);
+
+    // render lead time in us
+    uint32_t x = LCD_WIDTH / 2 - screen_strlen("1234US") / 2;
+    screen_put_uint14(x, y + 4, 1, mixer_get_lead_time());
+    screen_puts_xy(x + 4*w, y + 4, 1, "US");
+
+    // measured stick to air latency, last frame and worst case
+    mixer_get_latency(&last, &max);
+    screen_set_font(font_tomthumb3x5, 0, &w);
+    y += 15 + 2;
+    x = LCD_WIDTH / 2 - screen_strlen("LAT 1234 MAX 1234") / 2;
+    screen_puts_xy(x, y, 1, "LAT");
+    gui_put_count(x + 4*w, y, last);
+    screen_puts_xy(x + 9*w, y, 1, "MAX");
+    gui_put_count(x + 13*w, y, max);
+}
+
+static void gui_cb_render_option_a7105(uint32_t UNUSED(x), uint32_t y) {
+    uint8_t protocol = storage.model[storage.current_model].a7105_protocol;
+    screen_set_font(font_system5x7, 0, 0);
+
+    // render +/- button
+    gui_add_button(15, y, 15, 15, "-", &gui_cb_model_a7105_dec);
+    gui_add_button(LCD_WIDTH - 15 - 15, y, 15, 15, "+", &gui_cb_model_a7105_inc);
+    screen_puts_centered(y + 4, 1, (char *)PROTOCOL_GetName(protocol));
+
+    // refused or stopped when it does not fit next to frsky or no module is fitted
+    screen_set_font(font_tomthumb3x5, 0, 0);
+    if (protocol == PROTOCOL_NONE) {
+        return;
+    }
+    if (radio_a7105_get_protocol() == protocol) {
+        screen_puts_centered(y + 15 + 2, 1, "RUNNING");
+    } else {
+        screen_puts_centered(y + 15 + 2, 1, "STOPPED");
+    }
+}
+
+static void gui_render_option_shaping(uint32_t y, uint8_t value, f_ptr_t dec, f_ptr_t inc) {
+    uint32_t w;
+    screen_set_font(font_system5x7, 0, &w);
+
+    // render +/- button
+    gui_add_button(15, y, 15, 15, "-", dec);
+    gui_add_button(LCD_WIDTH - 15 - 15, y, 15, 15, "+", inc);
+
+    // render stick and value, touch the stick name to select the next one
+    uint32_t x = LCD_WIDTH / 2 - screen_strlen("A 123") / 2;
+    screen_puts_xy(x, y + 4, 1, adc_get_channel_name(gui_shaping_channel, true));
+    screen_put_uint8(x + 2*w, y + 4, 1, value);
+    gui_touch_callback_register(15 + 15 + 2, LCD_WIDTH - 15 - 15 - 2, y, y + 15,
+                                &gui_cb_model_shaping_channel);
+}
+
+static void gui_cb_render_option_expo(uint32_t UNUSED(x), uint32_t y) {
+    MODEL_SHAPING_DESC *shaping =
+            &storage.model[storage.current_model].shaping[gui_shaping_channel];
+    gui_render_option_shaping(y, shaping->expo, &gui_cb_model_expo_dec, &gui_cb_model_expo_inc);
+}
+
+static void gui_cb_render_option_deadband(uint32_t UNUSED(x), uint32_t y) {
+    MODEL_SHAPING_DESC *shaping =
+            &storage.model[storage.current_model].shaping[gui_shaping_channel];
+    gui_render_option_shaping(y, shaping->deadband,
+                              &gui_cb_model_deadband_dec, &gui_cb_model_deadband_inc);
+}
+
 static void gui_config_model_render(void) {
     // header
     gui_config_header_render("MODEL SETTINGS");
@@ -1123,6 +1748,26 @@ static void gui_config_model_render(void) {
             case (GUI_SUBPAGE_SETTING_MODEL_TIMER) :
                 gui_render_option_window("TIMER", &gui_cb_render_option_timer);
                 break;
+
+            case (GUI_SUBPAGE_SETTING_MODEL_RATE) :
+                gui_render_option_window("FRAME RATE", &gui_cb_render_option_rate);
+                break;
+
+            case (GUI_SUBPAGE_SETTING_MODEL_LEAD) :
+                gui_render_option_window("LEAD TIME", &gui_cb_render_option_lead);
+                break;
+
+            case (GUI_SUBPAGE_SETTING_MODEL_A7105) :
+                gui_render_option_window("A7105 PROTOCOL", &gui_cb_render_option_a7105);
+                break;
+
+            case (GUI_SUBPAGE_SETTING_MODEL_EXPO) :
+                gui_render_option_window("EXPO", &gui_cb_render_option_expo);
+                break;
+
+            case (GUI_SUBPAGE_SETTING_MODEL_DBAND) :
+                gui_render_option_window("DEADBAND", &gui_cb_render_option_deadband);
+                break;
         }
     }
 }
@@ -27,7 +27,8 @@
 #define GUI_NEXT_CLICK_X (LCD_WIDTH - GUI_PREV_CLICK_X)
 #define GUI_PAGE_MAIN     0
 #define GUI_PAGE_STICKS   1
-#define GUI_PAGE_SETTINGS 2
+#define GUI_PAGE_HISTORY  2
+#define GUI_PAGE_SETTINGS 3
 #define GUI_MAX_PAGE GUI_PAGE_SETTINGS
 #define GUI_STATUSBAR_FONT font_tomthumb3x5
 
@@ -65,6 +66,8 @@ typedef struct {
 #define GUI_PAGE_SETUP_CLONETX    (GUI_PAGE_SETUP_FLAG | 1)
 #define GUI_PAGE_SETUP_BIND       (GUI_PAGE_SETUP_FLAG | 2)
 #define GUI_PAGE_SETUP_BOOTLOADER (GUI_PAGE_SETUP_FLAG | 3)
+#define GUI_PAGE_SETUP_SCANNER    (GUI_PAGE_SETUP_FLAG | 4)
+#define GUI_PAGE_SETUP_STATS      (GUI_PAGE_SETUP_FLAG | 5)
 
 #define GUI_PAGE_CONFIG_MAIN            (GUI_PAGE_CONFIG_FLAG | 0)
 #define GUI_PAGE_CONFIG_STICK_CAL       (GUI_PAGE_CONFIG_FLAG | 1)
@@ -74,6 +77,11 @@ typedef struct {
 #define GUI_SUBPAGE_SETTING_MODEL_NAME  0
 #define GUI_SUBPAGE_SETTING_MODEL_SCALE 1
 #define GUI_SUBPAGE_SETTING_MODEL_TIMER 2
+#define GUI_SUBPAGE_SETTING_MODEL_RATE  3
+#define GUI_SUBPAGE_SETTING_MODEL_EXPO  4
+#define GUI_SUBPAGE_SETTING_MODEL_DBAND 5
+#define GUI_SUBPAGE_SETTING_MODEL_LEAD  6
+#define GUI_SUBPAGE_SETTING_MODEL_A7105 7
 
 void gui_init(void);
 void gui_loop(void);
@@ -0,0 +1,202 @@
+/*
+    Copyright 2016 fishpepper <AT> gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    author: fishpepper <AT> gmail.com
+*/
+
+#include "history.h"
+#include "telemetry.h"
+#include "linkstats.h"
+#include "timeout.h"
+#include "debug.h"
+
+// completed buckets, oldest first
+static history_bucket_t history_bucket[HISTORY_SENSOR_COUNT][HISTORY_BUCKET_COUNT];
+static uint8_t  history_count;
+// number of samples that make up one bucket, doubles on every merge
+static uint16_t history_span;
+
+// bucket that is currently being filled, stale sensors are not sampled
+static int16_t  history_acc_min[HISTORY_SENSOR_COUNT];
+static int16_t  history_acc_max[HISTORY_SENSOR_COUNT];
+static int32_t  history_acc_sum[HISTORY_SENSOR_COUNT];
+static uint16_t history_acc_count[HISTORY_SENSOR_COUNT];
+static uint16_t history_acc_samples;
+
+static uint32_t history_last_sample_ms;
+
+static const char *history_sensor_name[HISTORY_SENSOR_COUNT] = {
+    "VOLTAGE",
+    "CURRENT",
+    "RSSI",
+    "LQI"
+};
+
+// internal functions
+static void history_sample(uint8_t sensor, int16_t value);
+static void history_sample_telemetry(uint8_t sensor, uint8_t value_index, int32_t value);
+static void history_commit(void);
+static void history_decimate(void);
+static int16_t history_clamp(int32_t value);
+
+void history_init(void) {
+    debug("history: init\n"); debug_flush();
+
+    history_reset();
+}
+
+void history_reset(void) {
+    uint32_t i;
+
+    history_count          = 0;
+    history_span           = 1;
+    history_acc_samples    = 0;
+    history_last_sample_ms = timeout_get_ms();
+    for (i = 0; i < HISTORY_SENSOR_COUNT; i++) {
+        history_acc_count[i] = 0;
+    }
+}
+
+void history_update(void) {
+    linkstats_t stats;
+    uint32_t now = timeout_get_ms();
+
+    if ((now - history_last_sample_ms) < HISTORY_SAMPLE_MS) {
+        return;
+    }
+    history_last_sample_ms += HISTORY_SAMPLE_MS;
+
+    if ((history_acc_samples == 0) && (history_count >= HISTORY_BUCKET_COUNT)) {
+        // merge before the next bucket starts, it already covers the doubled span
+        history_decimate();
+    }
+
+    linkstats_get(&stats);
+
+    history_sample_telemetry(HISTORY_SENSOR_VOLTAGE, TELEMETRY_VALUE_VOLTAGE,
+                             telemetry_get_value(TELEMETRY_VALUE_VOLTAGE));
+    history_sample_telemetry(HISTORY_SENSOR_CURRENT, TELEMETRY_VALUE_CURRENT,
+                             telemetry_get_value(TELEMETRY_VALUE_CURRENT));
+    history_sample_telemetry(HISTORY_SENSOR_RSSI, TELEMETRY_VALUE_RSSI, stats.rssi);
+    history_sample_telemetry(HISTORY_SENSOR_LQI, TELEMETRY_VALUE_LQI, stats.lqi);
+    history_acc_samples++;
+
+    if (history_acc_samples >= history_span) {
+        history_commit();
+    }
+}
+
+static int16_t history_clamp(int32_t value) {
+    if (value > INT16_MAX) return INT16_MAX;
+    if (value < INT16_MIN) return INT16_MIN;
+    return value;
+}
+
+static void history_sample_telemetry(uint8_t sensor, uint8_t value_index, int32_t value) {
+    // a lost link or sensor keeps its last value, do not record it
+    if (telemetry_is_stale(value_index)) {
+        return;
+    }
+    history_sample(sensor, history_clamp(value));
+}
+
+static void history_sample(uint8_t sensor, int16_t value) {
+    if (history_acc_count[sensor] == 0) {
+        history_acc_min[sensor] = value;
+        history_acc_max[sensor] = value;
+        history_acc_sum[sensor] = value;
+    } else {
+        if (value < history_acc_min[sensor]) history_acc_min[sensor] = value;
+        if (value > history_acc_max[sensor]) history_acc_max[sensor] = value;
+        history_acc_sum[sensor] += value;
+    }
+    history_acc_count[sensor]++;
+}
+
+static void history_commit(void) {
+    uint32_t i;
+
+    for (i = 0; i < HISTORY_SENSOR_COUNT; i++) {
+        history_bucket_t *bucket = &history_bucket[i][history_count];
+        if (history_acc_count[i] == 0) {
+            // stale the whole time
+            bucket->min = INT16_MAX;
+            bucket->max = INT16_MIN;
+            bucket->avg = 0;
+        } else {
+            bucket->min = history_acc_min[i];
+            bucket->max = history_acc_max[i];
+            bucket->avg = history_acc_sum[i] / history_acc_count[i];
+        }
+        history_acc_count[i] = 0;
+    }
+
+    history_count++;
+    history_acc_samples = 0;
+}
+
+static void history_decimate(void) {
+    uint32_t i, j;
+
+    // merge pairs of buckets, both cover the same time span so the new
+    // average is the mean of both averages. empty buckets are left out
+    for (i = 0; i < HISTORY_SENSOR_COUNT; i++) {
+        history_bucket_t *bucket = history_bucket[i];
+        for (j = 0; j < HISTORY_BUCKET_COUNT / 2; j++) {
+            history_bucket_t *a = &bucket[2*j];
+            history_bucket_t *b = &bucket[2*j + 1];
+            if (HISTORY_BUCKET_EMPTY(a)) {
+                bucket[j] = *b;
+                continue;
+            }
+            if (HISTORY_BUCKET_EMPTY(b)) {
+                bucket[j] = *a;
+                continue;
+            }
+            bucket[j].min = (a->min < b->min) ? a->min : b->min;
+            bucket[j].max = (a->max > b->max) ? a->max : b->max;
+            bucket[j].avg = ((int32_t)a->avg + b->avg) / 2;
+        }
+    }
+
+    history_count = HISTORY_BUCKET_COUNT / 2;
+    history_span *= 2;
+}
+
+uint8_t history_get_count(void) {
+    return history_count;
+}
+
+uint32_t history_get_bucket_ms(void) {
+    return (uint32_t)history_span * HISTORY_SAMPLE_MS;
+}
+
+void history_get_bucket(uint8_t sensor, uint8_t index, history_bucket_t *bucket) {
+    if ((sensor >= HISTORY_SENSOR_COUNT) || (index >= history_count)) {
+        bucket->min = 0;
+        bucket->max = 0;
+        bucket->avg = 0;
+        return;
+    }
+    *bucket = history_bucket[sensor][index];
+}
+
+const char *history_get_sensor_name(uint8_t sensor) {
+    if (sensor >= HISTORY_SENSOR_COUNT) {
+        return "";
+    }
+    return history_sensor_name[sensor];
+}
@@ -0,0 +1,56 @@
+/*
+    Copyright 2016 fishpepper <AT> gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    author: fishpepper <AT> gmail.com
+*/
+
+#ifndef HISTORY_H_
+#define HISTORY_H_
+
+#include <stdint.h>
+
+// sensors that are recorded over the whole flight
+#define HISTORY_SENSOR_VOLTAGE  0
+#define HISTORY_SENSOR_CURRENT  1
+#define HISTORY_SENSOR_RSSI     2
+#define HISTORY_SENSOR_LQI      3
+#define HISTORY_SENSOR_COUNT    4
+
+// number of buckets per sensor (must be even). once all buckets are
+// used, neighbouring buckets are merged and every bucket covers twice
+// the time, so memory use does not depend on the flight time
+#define HISTORY_BUCKET_COUNT    48
+#define HISTORY_SAMPLE_MS       1000
+
+typedef struct {
+    int16_t min;
+    int16_t max;
+    int16_t avg;
+} history_bucket_t;
+
+// a bucket without samples (sensor stale the whole time) has min > max
+#define HISTORY_BUCKET_EMPTY(_b) ((_b)->min > (_b)->max)
+
+void history_init(void);
+void history_reset(void);
+void history_update(void);
+
+uint8_t history_get_count(void);
+uint32_t history_get_bucket_ms(void);
+void history_get_bucket(uint8_t sensor, uint8_t index, history_bucket_t *bucket);
+const char *history_get_sensor_name(uint8_t sensor);
+
+#endif  // HISTORY_H_
@@ -0,0 +1,229 @@
+/*
+    Copyright 2016 fishpepper <AT> gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    author: fishpepper <AT> gmail.com
+*/
+
+#include "linkstats.h"
+#include "debug.h"
+
+#include <libopencm3/cm3/cortex.h>
+
+// one telemetry slot in the rolling window
+typedef struct {
+    uint8_t received;
+    uint8_t rssi;
+    uint8_t rssi_rx;
+    uint8_t lqi;
+} linkstats_entry_t;
+
+// per hop channel state, rssi and lqi are running averages
+typedef struct {
+    uint8_t  history;
+    uint8_t  filled;
+    uint8_t  received_in_window;
+    uint8_t  rssi;
+    uint8_t  rssi_rx;
+    uint8_t  lqi;
+    uint16_t received;
+    uint16_t lost;
+} linkstats_channel_t;
+
+// rolling window, the sums are updated with every entry that
+// enters or leaves the ring so each packet costs O(1)
+static linkstats_entry_t linkstats_ring[LINKSTATS_WINDOW];
+static uint8_t  linkstats_ring_index;
+static uint8_t  linkstats_ring_filled;
+static uint8_t  linkstats_ring_received;
+static uint16_t linkstats_ring_rssi_sum;
+static uint16_t linkstats_ring_rssi_rx_sum;
+static uint16_t linkstats_ring_lqi_sum;
+static uint32_t linkstats_received;
+static uint32_t linkstats_lost;
+
+static linkstats_channel_t linkstats_channel[LINKSTATS_CHANNEL_COUNT];
+
+// internal functions
+static void linkstats_add(uint8_t hop_index, uint8_t received, uint8_t rssi, uint8_t rssi_rx, uint8_t lqi);
+static uint8_t linkstats_percent(uint8_t count, uint8_t total);
+static uint8_t linkstats_average(uint8_t average, uint8_t sample);
+
+void linkstats_init(void) {
+    debug("linkstats: init\n"); debug_flush();
+
+    linkstats_reset();
+}
+
+void linkstats_reset(void) {
+    uint32_t i;
+
+    uint32_t primask = cm_mask_interrupts(1);
+
+    for (i = 0; i < LINKSTATS_WINDOW; i++) {
+        linkstats_ring[i].received = 0;
+    }
+    linkstats_ring_index       = 0;
+    linkstats_ring_filled      = 0;
+    linkstats_ring_received    = 0;
+    linkstats_ring_rssi_sum    = 0;
+    linkstats_ring_rssi_rx_sum = 0;
+    linkstats_ring_lqi_sum     = 0;
+    linkstats_received         = 0;
+    linkstats_lost             = 0;
+
+    for (i = 0; i < LINKSTATS_CHANNEL_COUNT; i++) {
+        linkstats_channel[i].history            = 0;
+        linkstats_channel[i].filled             = 0;
+        linkstats_channel[i].received_in_window = 0;
+        linkstats_channel[i].rssi               = 0;
+        linkstats_channel[i].rssi_rx            = 0;
+        linkstats_channel[i].lqi                = 0;
+        linkstats_channel[i].received           = 0;
+        linkstats_channel[i].lost               = 0;
+    }
+
+    cm_mask_interrupts(primask);
+}
+
+// NOTE: both are called from the rf isrs
+void linkstats_add_packet(uint8_t hop_index, uint8_t rssi, uint8_t rssi_rx, uint8_t lqi) {
+    linkstats_add(hop_index, 1, rssi, rssi_rx, lqi);
+}
+
+void linkstats_add_loss(uint8_t hop_index) {
+    linkstats_add(hop_index, 0, 0, 0, 0);
+}
+
+static void linkstats_add(uint8_t hop_index, uint8_t received, uint8_t rssi, uint8_t rssi_rx, uint8_t lqi) {
+    linkstats_entry_t *entry = &linkstats_ring[linkstats_ring_index];
+
+    // drop the oldest entry from the sums
+    if (linkstats_ring_filled == LINKSTATS_WINDOW) {
+        if (entry->received) {
+            linkstats_ring_received--;
+            linkstats_ring_rssi_sum    -= entry->rssi;
+            linkstats_ring_rssi_rx_sum -= entry->rssi_rx;
+            linkstats_ring_lqi_sum     -= entry->lqi;
+        }
+    } else {
+        linkstats_ring_filled++;
+    }
+
+    entry->received = received;
+    entry->rssi     = rssi;
+    entry->rssi_rx  = rssi_rx;
+    entry->lqi      = lqi;
+
+    if (received) {
+        linkstats_ring_received++;
+        linkstats_ring_rssi_sum    += rssi;
+        linkstats_ring_rssi_rx_sum += rssi_rx;
+        linkstats_ring_lqi_sum     += lqi;
+        linkstats_received++;
+    } else {
+        linkstats_lost++;
+    }
+
+    linkstats_ring_index = (linkstats_ring_index + 1) & (LINKSTATS_WINDOW - 1);
+
+    if (hop_index >= LINKSTATS_CHANNEL_COUNT) {
+        return;
+    }
+
+    // per channel outcome history, the msb leaves the window
+    linkstats_channel_t *channel = &linkstats_channel[hop_index];
+    if (channel->filled == LINKSTATS_CHANNEL_WINDOW) {
+        channel->received_in_window -= (channel->history >> (LINKSTATS_CHANNEL_WINDOW - 1)) & 1;
+    } else {
+        channel->filled++;
+    }
+    channel->history = (channel->history << 1) | received;
+    channel->received_in_window += received;
+
+    if (received) {
+        if (channel->received == 0) {
+            // first packet, start the averages here
+            channel->rssi    = rssi;
+            channel->rssi_rx = rssi_rx;
+            channel->lqi     = lqi;
+        } else {
+            channel->rssi    = linkstats_average(channel->rssi,    rssi);
+            channel->rssi_rx = linkstats_average(channel->rssi_rx, rssi_rx);
+            channel->lqi     = linkstats_average(channel->lqi,     lqi);
+        }
+        if (channel->received != 0xFFFF) channel->received++;
+    } else {
+        if (channel->lost != 0xFFFF) channel->lost++;
+    }
+}
+
+// moves a quarter of the way to the sample. the step is rounded to
+// nearest in both directions, an arithmetic shift alone rounds towards
+// -inf and drags the average down
+static uint8_t linkstats_average(uint8_t average, uint8_t sample) {
+    int16_t delta = (int16_t)sample - average;
+
+    if (delta >= 0) {
+        return average + ((delta + 2) >> 2);
+    } else {
+        return average - ((-delta + 2) >> 2);
+    }
+}
+
+static uint8_t linkstats_percent(uint8_t count, uint8_t total) {
+    if (total == 0) {
+        return 0;
+    }
+    return ((uint16_t)count * 100) / total;
+}
+
+void linkstats_get(linkstats_t *stats) {
+    uint32_t primask = cm_mask_interrupts(1);
+
+    stats->quality  = linkstats_percent(linkstats_ring_received, linkstats_ring_filled);
+    stats->received = linkstats_received;
+    stats->lost     = linkstats_lost;
+
+    if (linkstats_ring_received) {
+        stats->rssi    = linkstats_ring_rssi_sum    / linkstats_ring_received;
+        stats->rssi_rx = linkstats_ring_rssi_rx_sum / linkstats_ring_received;
+        stats->lqi     = linkstats_ring_lqi_sum     / linkstats_ring_received;
+    } else {
+        stats->rssi    = 0;
+        stats->rssi_rx = 0;
+        stats->lqi     = 0;
+    }
+
+    cm_mask_interrupts(primask);
+}
+
+void linkstats_get_channel(uint8_t hop_index, linkstats_t *stats) {
+    if (hop_index >= LINKSTATS_CHANNEL_COUNT) {
+        hop_index = 0;
+    }
+
+    uint32_t primask = cm_mask_interrupts(1);
+
+    linkstats_channel_t *channel = &linkstats_channel[hop_index];
+    stats->quality  = linkstats_percent(channel->received_in_window, channel->filled);
+    stats->rssi     = channel->rssi;
+    stats->rssi_rx  = channel->rssi_rx;
+    stats->lqi      = channel->lqi;
+    stats->received = channel->received;
+    stats->lost     = channel->lost;
+
+    cm_mask_interrupts(primask);
+}
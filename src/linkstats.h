@@ -0,0 +1,53 @@
+/*
+    Copyright 2016 fishpepper <AT> gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    author: fishpepper <AT> gmail.com
+*/
+
+#ifndef LINKSTATS_H_
+#define LINKSTATS_H_
+
+#include <stdint.h>
+#include "frsky.h"
+
+// rolling window over the last telemetry slots (power of two)
+#define LINKSTATS_WINDOW         32
+// per hop channel outcome history, one bit per telemetry slot
+#define LINKSTATS_CHANNEL_COUNT  FRSKY_HOPTABLE_SIZE
+#define LINKSTATS_CHANNEL_WINDOW 8
+
+typedef struct {
+    // percentage of telemetry packets received within the window
+    uint8_t  quality;
+    // averages over the received packets
+    uint8_t  rssi;
+    uint8_t  rssi_rx;
+    uint8_t  lqi;
+    // totals since the last reset
+    uint32_t received;
+    uint32_t lost;
+} linkstats_t;
+
+void linkstats_init(void);
+void linkstats_reset(void);
+
+void linkstats_add_packet(uint8_t hop_index, uint8_t rssi, uint8_t rssi_rx, uint8_t lqi);
+void linkstats_add_loss(uint8_t hop_index);
+
+void linkstats_get(linkstats_t *stats);
+void linkstats_get_channel(uint8_t hop_index, linkstats_t *stats);
+
+#endif  // LINKSTATS_H_
@@ -39,6 +39,13 @@
 #include "gui.h"
 #include "eeprom.h"
 #include "usb.h"
+#include "mixer.h"
+#include "shaping.h"
+#include "radio.h"
+#include "packet_pool.h"
+#include "linkstats.h"
+#include "history.h"
+#include "protocol/common.h"
 
 
 #include <stdlib.h>
@@ -183,7 +190,17 @@ int main(void) {
     eeprom_init();
     storage_init();
 
+    CLOCK_Init();
+    shaping_init();
+    mixer_init();
+
+    packet_pool_init();
+    linkstats_init();
+    history_init();
+
+    radio_init();
     frsky_init();
+    radio_a7105_select(storage.model[storage.current_model].a7105_protocol);
 
     usb_init();
 
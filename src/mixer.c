@@ -0,0 +1,256 @@
+/*
+    Copyright 2016 fishpepper <AT> gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    author: fishpepper <AT> gmail.com
+*/
+
+#include "mixer.h"
+#include "adc.h"
+#include "shaping.h"
+#include "storage.h"
+#include "debug.h"
+#include "macros.h"
+#include "protocol/common.h"
+
+// the last pass runs this long before the rf slot
+static volatile uint16_t mixer_lead_time_us;
+static volatile uint32_t mixer_snapshot_us;
+static volatile uint8_t  mixer_snapshot_valid;
+
+// stick to air latency of the last frame and the worst case so far
+static volatile uint16_t mixer_latency_us;
+static volatile uint16_t mixer_latency_max_us;
+
+// execution time of the last pass and the worst case so far
+static volatile uint16_t mixer_runtime_us;
+static volatile uint16_t mixer_runtime_max_us;
+
+// values inside the mixer are Q15, +/-100% = +/-MIXER_VALUE_MAX
+#define MIXER_VALUE_MAX     32767
+// weights are Q14 so that +/-127% fit into 16 bit
+#define MIXER_WEIGHT_SHIFT  14
+
+#define MIXER_OP_SET        0
+#define MIXER_OP_ADD        1
+#define MIXER_OP_MUL        2
+
+// one compiled mix, all percentages already converted to fixed point
+typedef struct {
+    uint8_t op;
+    uint8_t source;
+    uint8_t destination;
+    // input that enables this mix, MIXER_SOURCE_NONE = always
+    uint8_t condition;
+    uint8_t condition_high;
+    int16_t weight;
+    int16_t offset;
+} mixer_instruction_t;
+
+#define MIXER_PROGRAM_SIZE  (MIXER_OUTPUT_COUNT + STORAGE_MIX_COUNT)
+
+// double buffered program, the isr may run while a model is compiled
+static mixer_instruction_t mixer_program[2][MIXER_PROGRAM_SIZE];
+static uint8_t mixer_program_count[2];
+static volatile uint8_t mixer_program_index;
+
+// internal functions
+static uint8_t mixer_compile_mix(mixer_instruction_t *ins, uint8_t op, uint8_t source,
+                                 uint8_t destination, int8_t weight, int8_t offset, uint8_t sw);
+
+void mixer_init(void) {
+    debug("mixer: init\n"); debug_flush();
+
+    mixer_lead_time_us   = MIXER_LEAD_TIME_DEFAULT_US;
+    mixer_snapshot_valid = 0;
+    mixer_latency_us     = 0;
+    mixer_latency_max_us = 0;
+    mixer_runtime_us     = 0;
+    mixer_runtime_max_us = 0;
+    mixer_program_index  = 0;
+    mixer_program_count[0] = 0;
+
+    mixer_compile();
+    mixer_process();
+}
+
+static uint8_t mixer_compile_mix(mixer_instruction_t *ins, uint8_t op, uint8_t source,
+                                 uint8_t destination, int8_t weight, int8_t offset, uint8_t sw) {
+    if ((source >= MIXER_SOURCE_COUNT) || (destination >= MIXER_OUTPUT_COUNT) ||
+        (sw >= MIXER_SWITCH_COUNT)) {
+        // invalid or unused
+        return 0;
+    }
+
+    ins->op          = op;
+    ins->source      = source;
+    ins->destination = destination;
+    ins->weight      = ((int32_t)weight << MIXER_WEIGHT_SHIFT) / 100;
+    ins->offset      = ((int32_t)max(-100, min(100, offset)) * MIXER_VALUE_MAX) / 100;
+
+    if (sw == MIXER_SWITCH_ALWAYS) {
+        ins->condition      = MIXER_SOURCE_NONE;
+        ins->condition_high = 0;
+    } else {
+        ins->condition      = CHANNEL_ID_CH0 + (sw - 1) / 2;
+        ins->condition_high = ((sw - 1) & 1) == 0;
+    }
+    return 1;
+}
+
+// translate the mixes of the current model into the program that
+// runs every rf frame. called on model load and on setting changes
+void mixer_compile(void) {
+    uint32_t i;
+    uint8_t next = mixer_program_index ^ 1;
+    mixer_instruction_t *ins = mixer_program[next];
+    uint8_t count = 0;
+    MODEL_DESC *model = &storage.model[storage.current_model];
+
+    // the input stage and the lead time belong to the model as well
+    shaping_compile();
+    mixer_set_lead_time(model->mixer_lead * MIXER_LEAD_TIME_STEP_US);
+
+    // every output starts as a copy of its input
+    for (i = 0; i < MIXER_OUTPUT_COUNT; i++) {
+        count += mixer_compile_mix(&ins[count], MIXER_OP_SET, i, i, 100, 0, MIXER_SWITCH_ALWAYS);
+    }
+
+    for (i = 0; i < STORAGE_MIX_COUNT; i++) {
+        MODEL_MIX_DESC *mix = &model->mix[i];
+        uint8_t op;
+
+        switch (mix->mode) {
+            default:
+            case (MIXER_MODE_REPLACE)  : op = MIXER_OP_SET; break;
+            case (MIXER_MODE_ADD)      : op = MIXER_OP_ADD; break;
+            case (MIXER_MODE_MULTIPLY) : op = MIXER_OP_MUL; break;
+        }
+
+        count += mixer_compile_mix(&ins[count], op, mix->source, mix->destination,
+                                   mix->weight, mix->offset, mix->sw);
+    }
+
+    mixer_program_count[next] = count;
+
+    // publish
+    mixer_program_index = next;
+}
+
+// adc snapshot -> calibration -> shaping -> mix -> Channels[]
+// NOTE: this is called from the rf isrs, keep it short
+void mixer_process(void) {
+    uint32_t i;
+    int32_t data[CHANNEL_ID_SIZE];
+    int32_t input[MIXER_SOURCE_COUNT];
+    int32_t output[MIXER_OUTPUT_COUNT];
+
+    uint32_t start = CLOCK_getus();
+    mixer_snapshot_us = start;
+
+    adc_get_channels_rescaled(data);
+    for (i = 0; i < SHAPING_CHANNEL_COUNT; i++) {
+        // sticks go through their lookup table, +/-SHAPING_OUTPUT_MAX
+        input[i] = shaping_apply(i, data[i]);
+    }
+    for (i = SHAPING_CHANNEL_COUNT; i < CHANNEL_ID_SIZE; i++) {
+        // rescaled data is +/-3200 -> Q15, 10486 / 1024 ~ 32768 / 3200
+        input[i] = (data[i] * 10486) >> 10;
+    }
+    input[MIXER_SOURCE_MAX] = MIXER_VALUE_MAX;
+
+    for (i = 0; i < MIXER_OUTPUT_COUNT; i++) {
+        output[i] = 0;
+    }
+
+    // run the compiled program
+    uint8_t index = mixer_program_index;
+    mixer_instruction_t *ins = mixer_program[index];
+    mixer_instruction_t *end = ins + mixer_program_count[index];
+    for (; ins < end; ins++) {
+        if ((ins->condition != MIXER_SOURCE_NONE) &&
+            ((input[ins->condition] > 0) != ins->condition_high)) {
+            continue;
+        }
+
+        int32_t value = ((input[ins->source] * ins->weight) >> MIXER_WEIGHT_SHIFT) + ins->offset;
+        int32_t *out  = &output[ins->destination];
+
+        switch (ins->op) {
+            default:
+            case (MIXER_OP_SET) :
+                *out = value;
+                break;
+
+            case (MIXER_OP_ADD) :
+                *out += value;
+                break;
+
+            case (MIXER_OP_MUL) :
+                value = max(-MIXER_VALUE_MAX, min(MIXER_VALUE_MAX, value));
+                *out  = max(-MIXER_VALUE_MAX, min(MIXER_VALUE_MAX, *out));
+                *out  = (*out * value) >> 15;
+                break;
+        }
+    }
+
+    for (i = 0; i < MIXER_OUTPUT_COUNT; i++) {
+        // Q15 -> +/-CHAN_MAX_VALUE
+        int32_t value = max(-MIXER_VALUE_MAX, min(MIXER_VALUE_MAX, output[i]));
+        Channels[i] = (value * CHAN_MAX_VALUE) >> 15;
+    }
+
+    mixer_snapshot_valid = 1;
+
+    uint32_t runtime = min(CLOCK_getus() - start, 0xFFFF);
+    mixer_runtime_us = runtime;
+    if (runtime > mixer_runtime_max_us) {
+        mixer_runtime_max_us = runtime;
+    }
+}
+
+// called by the protocols right before the channel data goes on air
+void mixer_frame_sent(void) {
+    if (!mixer_snapshot_valid) {
+        return;
+    }
+    mixer_snapshot_valid = 0;
+
+    uint32_t latency = CLOCK_getus() - mixer_snapshot_us;
+    latency = min(latency, 0xFFFF);
+
+    mixer_latency_us = latency;
+    if (latency > mixer_latency_max_us) {
+        mixer_latency_max_us = latency;
+    }
+}
+
+void mixer_set_lead_time(uint16_t us) {
+    mixer_lead_time_us = min(us, MIXER_LEAD_TIME_MAX_US);
+}
+
+uint16_t mixer_get_lead_time(void) {
+    return mixer_lead_time_us;
+}
+
+void mixer_get_latency(uint16_t *last_us, uint16_t *max_us) {
+    *last_us = mixer_latency_us;
+    *max_us  = mixer_latency_max_us;
+}
+
+void mixer_get_runtime(uint16_t *last_us, uint16_t *max_us) {
+    *last_us = mixer_runtime_us;
+    *max_us  = mixer_runtime_max_us;
+}
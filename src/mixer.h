@@ -0,0 +1,62 @@
+/*
+    Copyright 2016 fishpepper <AT> gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    author: fishpepper <AT> gmail.com
+*/
+
+#ifndef MIXER_H_
+#define MIXER_H_
+
+#include <stdint.h>
+#include "adc.h"
+
+// the mixer runs this long before each rf slot (0 = only on request)
+#define MIXER_LEAD_TIME_DEFAULT_US 300
+#define MIXER_LEAD_TIME_MAX_US     8000
+// the per model lead time is stored in steps of this size
+#define MIXER_LEAD_TIME_STEP_US    100
+
+// outputs written to Channels[], every output follows its input
+// unless a mix changes it
+#define MIXER_OUTPUT_COUNT         CHANNEL_ID_SIZE
+
+// mix sources: the inputs (CHANNEL_ID_*) and a constant +100%
+#define MIXER_SOURCE_MAX           CHANNEL_ID_SIZE
+#define MIXER_SOURCE_COUNT         (CHANNEL_ID_SIZE + 1)
+#define MIXER_SOURCE_NONE          0xFF
+
+// how a mix is combined with its destination
+#define MIXER_MODE_REPLACE         0
+#define MIXER_MODE_ADD             1
+#define MIXER_MODE_MULTIPLY        2
+
+// a mix can be restricted to one position of the aux switches CH0..CH3
+#define MIXER_SWITCH_ALWAYS        0
+#define MIXER_SWITCH_HIGH(_n)      (1 + 2 * (_n))
+#define MIXER_SWITCH_LOW(_n)       (2 + 2 * (_n))
+#define MIXER_SWITCH_COUNT         9
+
+void mixer_init(void);
+void mixer_compile(void);
+void mixer_process(void);
+void mixer_frame_sent(void);
+
+void mixer_set_lead_time(uint16_t us);
+uint16_t mixer_get_lead_time(void);
+void mixer_get_latency(uint16_t *last_us, uint16_t *max_us);
+void mixer_get_runtime(uint16_t *last_us, uint16_t *max_us);
+
+#endif  // MIXER_H_
@@ -0,0 +1,97 @@
+/*
+    Copyright 2016 fishpepper <AT> gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    author: fishpepper <AT> gmail.com
+*/
+
+#include "packet_pool.h"
+#include "debug.h"
+
+#include <libopencm3/cm3/cortex.h>
+
+// fixed pool of radio packet buffers. a buffer is owned by exactly one
+// stage at a time (frame builder, spi dma, rx decoder), frames are built
+// and decoded in place and handed on instead of being copied
+static packet_buffer_t packet_pool[PACKET_POOL_COUNT];
+static uint8_t packet_pool_free_count;
+static uint8_t packet_pool_min_free;
+static uint16_t packet_pool_failures;
+
+void packet_pool_init(void) {
+    uint32_t i;
+
+    debug("packet_pool: init\n"); debug_flush();
+
+    for (i = 0; i < PACKET_POOL_COUNT; i++) {
+        packet_pool[i].owner = PACKET_OWNER_FREE;
+        packet_pool[i].len   = 0;
+    }
+    packet_pool_free_count = PACKET_POOL_COUNT;
+    packet_pool_min_free   = PACKET_POOL_COUNT;
+    packet_pool_failures   = 0;
+}
+
+// returns 0 if the pool is exhausted
+packet_buffer_t *packet_pool_alloc(uint8_t owner) {
+    packet_buffer_t *packet = 0;
+    uint32_t i;
+
+    // called from several isrs and the main loop
+    uint32_t primask = cm_mask_interrupts(1);
+
+    for (i = 0; i < PACKET_POOL_COUNT; i++) {
+        if (packet_pool[i].owner == PACKET_OWNER_FREE) {
+            packet = &packet_pool[i];
+            packet->owner = owner;
+            packet->len   = 0;
+            packet_pool_free_count--;
+            if (packet_pool_free_count < packet_pool_min_free) {
+                packet_pool_min_free = packet_pool_free_count;
+            }
+            break;
+        }
+    }
+
+    if (!packet && (packet_pool_failures != 0xFFFF)) {
+        packet_pool_failures++;
+    }
+
+    cm_mask_interrupts(primask);
+    return packet;
+}
+
+void packet_pool_handoff(packet_buffer_t *packet, uint8_t owner) {
+    packet->owner = owner;
+}
+
+void packet_pool_free(packet_buffer_t *packet) {
+    if (!packet) {
+        return;
+    }
+
+    uint32_t primask = cm_mask_interrupts(1);
+    if (packet->owner != PACKET_OWNER_FREE) {
+        packet->owner = PACKET_OWNER_FREE;
+        packet_pool_free_count++;
+    }
+    cm_mask_interrupts(primask);
+}
+
+void packet_pool_get_stats(uint8_t *free_count, uint8_t *min_free, uint16_t *failures) {
+    *free_count = packet_pool_free_count;
+    *min_free   = packet_pool_min_free;
+    *failures   = packet_pool_failures;
+}
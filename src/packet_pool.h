@@ -0,0 +1,51 @@
+/*
+    Copyright 2016 fishpepper <AT> gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    author: fishpepper <AT> gmail.com
+*/
+
+#ifndef PACKET_POOL_H_
+#define PACKET_POOL_H_
+
+#include <stdint.h>
+
+// frsky tx + frsky rx + active a7105 protocol + one spare
+#define PACKET_POOL_COUNT        4
+// largest frame is the 38 byte afhds2a packet
+#define PACKET_POOL_BUFFER_SIZE  40
+
+// who is allowed to touch the buffer right now
+#define PACKET_OWNER_FREE     0
+#define PACKET_OWNER_BUILDER  1
+#define PACKET_OWNER_DMA      2
+#define PACKET_OWNER_DECODER  3
+
+typedef struct {
+    // data has to stay the first member, see PACKET_POOL_FROM_DATA
+    uint8_t data[PACKET_POOL_BUFFER_SIZE];
+    uint8_t len;
+    volatile uint8_t owner;
+} __attribute__((aligned(4))) packet_buffer_t;
+
+#define PACKET_POOL_FROM_DATA(_d) ((packet_buffer_t *)(_d))
+
+void packet_pool_init(void);
+packet_buffer_t *packet_pool_alloc(uint8_t owner);
+void packet_pool_handoff(packet_buffer_t *packet, uint8_t owner);
+void packet_pool_free(packet_buffer_t *packet);
+void packet_pool_get_stats(uint8_t *free_count, uint8_t *min_free, uint16_t *failures);
+
+#endif  // PACKET_POOL_H_
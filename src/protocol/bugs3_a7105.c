@@ -15,9 +15,9 @@
 
 #include "common.h"
 #include "interface.h"
-#include "mixer.h"
-#include "config/model.h"
-#include "telemetry.h"
+// #include "mixer.h"
+// #include "config/model.h"
+// #include "telemetry.h"
 #include <string.h>
 #include <stdlib.h>
 #include <stdint.h>
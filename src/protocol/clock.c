@@ -0,0 +1,208 @@
+/*
+ This project is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ Deviation is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Deviation.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common.h"
+#include "config.h"
+#include "clocksource.h"
+#include "mixer.h"
+#include "radio.h"
+
+#include <libopencm3/stm32/rcc.h>
+#include <libopencm3/stm32/timer.h>
+#include <libopencm3/cm3/nvic.h>
+
+/*
+ * Protocol callback scheduler on the free running 32bit TIM2 (1us/tick).
+ * The next compare value is derived from the previous deadline, not from
+ * the time the callback finished, so the period does not drift.
+ * Compare channel 2 runs the mixer a configurable lead time before each
+ * callback so the channel data is as fresh as possible when it is sent.
+ * While the other radio holds a guard window the callback is held back
+ * until the window ends, the deadline of the following slot is kept.
+ */
+
+// a deadline closer than this is treated as already missed
+#define CLOCK_MIN_LEAD_US 2
+
+static u16 (*volatile timer_callback)(void);
+static u32 timer_deadline;
+static struct ClockStats clock_stats;
+
+static void update_hist(u16 *hist, u16 *max, u32 us)
+{
+    int i;
+    if (us > 0xFFFF)
+        us = 0xFFFF;
+    if (us > *max)
+        *max = us;
+    for (i = 0; i < CLOCK_HIST_BUCKETS - 1; i++) {
+        if (us < ((u32)CLOCK_HIST_FIRST_US << i))
+            break;
+    }
+    if (hist[i] != 0xFFFF)
+        hist[i]++;
+}
+
+static void arm_mixer(u32 now, u32 deadline)
+{
+    u16 lead = mixer_get_lead_time();
+    u32 mixer_deadline = deadline - lead;
+
+    if (! lead)
+        return;
+    if ((s32)(mixer_deadline - now) < CLOCK_MIN_LEAD_US) {
+        // not enough time left, run it right away
+        mixer_process();
+        return;
+    }
+    timer_set_oc_value(TIM2, TIM_OC2, mixer_deadline);
+    timer_clear_flag(TIM2, TIM_SR_CC2IF);
+    timer_enable_irq(TIM2, TIM_DIER_CC2IE);
+}
+
+void CLOCK_Init(void)
+{
+    rcc_periph_clock_enable(RCC_TIM2);
+    timer_reset(TIM2);
+
+    timer_set_prescaler(TIM2, (rcc_timer_frequency / 1000000) - 1);
+    timer_set_mode(TIM2, TIM_CR1_CKD_CK_INT, TIM_CR1_CMS_EDGE, TIM_CR1_DIR_UP);
+    timer_set_period(TIM2, 0xFFFFFFFF);
+    timer_disable_preload(TIM2);
+
+    // compare 1 only raises the interrupt, no output
+    timer_disable_oc_output(TIM2, TIM_OC1);
+    timer_set_oc_mode(TIM2, TIM_OC1, TIM_OCM_FROZEN);
+    timer_disable_oc_output(TIM2, TIM_OC2);
+    timer_set_oc_mode(TIM2, TIM_OC2, TIM_OCM_FROZEN);
+
+    nvic_set_priority(NVIC_TIM2_IRQ, NVIC_PRIO_PROTOCOL);
+    nvic_enable_irq(NVIC_TIM2_IRQ);
+
+    timer_enable_counter(TIM2);
+}
+
+void CLOCK_StartTimer(unsigned us, u16 (*cb)(void))
+{
+    u32 now;
+    if (! cb)
+        return;
+    nvic_disable_irq(NVIC_TIM2_IRQ);
+    timer_disable_irq(TIM2, TIM_DIER_CC1IE | TIM_DIER_CC2IE);
+    timer_callback = cb;
+    now = timer_get_counter(TIM2);
+    timer_deadline = now + us;
+    timer_set_oc_value(TIM2, TIM_OC1, timer_deadline);
+    timer_clear_flag(TIM2, TIM_SR_CC1IF);
+    timer_enable_irq(TIM2, TIM_DIER_CC1IE);
+    arm_mixer(now, timer_deadline);
+    nvic_enable_irq(NVIC_TIM2_IRQ);
+}
+
+void CLOCK_StopTimer(void)
+{
+    timer_disable_irq(TIM2, TIM_DIER_CC1IE | TIM_DIER_CC2IE);
+    timer_clear_flag(TIM2, TIM_SR_CC1IF | TIM_SR_CC2IF);
+    timer_callback = NULL;
+}
+
+void CLOCK_RunMixer(void)
+{
+    // with a lead time set the mixer already runs right before each slot
+    if (! mixer_get_lead_time())
+        mixer_process();
+}
+
+u32 CLOCK_getus(void)
+{
+    return timer_get_counter(TIM2);
+}
+
+void CLOCK_GetStats(struct ClockStats *stats)
+{
+    nvic_disable_irq(NVIC_TIM2_IRQ);
+    *stats = clock_stats;
+    nvic_enable_irq(NVIC_TIM2_IRQ);
+}
+
+void CLOCK_ResetStats(void)
+{
+    nvic_disable_irq(NVIC_TIM2_IRQ);
+    memset(&clock_stats, 0, sizeof(clock_stats));
+    nvic_enable_irq(NVIC_TIM2_IRQ);
+}
+
+void TIM2_IRQHandler(void)
+{
+    u32 start, now;
+    u16 us;
+
+    if ((TIM_DIER(TIM2) & TIM_DIER_CC2IE) && timer_get_flag(TIM2, TIM_SR_CC2IF)) {
+        timer_clear_flag(TIM2, TIM_SR_CC2IF);
+        timer_disable_irq(TIM2, TIM_DIER_CC2IE);
+        mixer_process();
+    }
+
+    if (! timer_get_flag(TIM2, TIM_SR_CC1IF))
+        return;
+    timer_clear_flag(TIM2, TIM_SR_CC1IF);
+
+    start = timer_get_counter(TIM2);
+    if (! timer_callback) {
+        CLOCK_StopTimer();
+        return;
+    }
+    u32 guard = radio_guard_remaining();
+    if (guard) {
+        // the air is in use, try again once the guard window is over.
+        // the guard query takes time, never set a compare value that
+        // already passed, that would cost a full timer wrap
+        if (clock_stats.deferred != 0xFFFF)
+            clock_stats.deferred++;
+        now = timer_get_counter(TIM2);
+        u32 retry = now + guard;
+        if ((s32)(retry - now) < CLOCK_MIN_LEAD_US)
+            retry = now + CLOCK_MIN_LEAD_US;
+        timer_set_oc_value(TIM2, TIM_OC1, retry);
+        return;
+    }
+
+    update_hist(clock_stats.late_hist, &clock_stats.late_max, start - timer_deadline);
+
+    mixer_frame_sent();
+    us = timer_callback();
+
+    now = timer_get_counter(TIM2);
+    update_hist(clock_stats.exec_hist, &clock_stats.exec_max, now - start);
+
+    if (! us) {
+        CLOCK_StopTimer();
+        return;
+    }
+    if (! timer_callback) {
+        // stopped from within the callback
+        return;
+    }
+
+    timer_deadline += us;
+    if ((s32)(timer_deadline - now) < CLOCK_MIN_LEAD_US) {
+        // the slot was missed, resync instead of firing back to back
+        if (clock_stats.overruns != 0xFFFF)
+            clock_stats.overruns++;
+        timer_deadline = now + CLOCK_MIN_LEAD_US;
+    }
+    timer_set_oc_value(TIM2, TIM_OC1, timer_deadline);
+    arm_mixer(now, timer_deadline);
+}
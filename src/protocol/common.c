@@ -0,0 +1,102 @@
+/*
+ This project is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ Deviation is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Deviation.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common.h"
+#include "timeout.h"
+#include "wdt.h"
+#include "crc16.h"
+#include "telemetry.h"
+
+#include <libopencm3/stm32/desig.h>
+
+struct Model Model = {
+    .fixed_id = 0,
+    .num_channels = 8,
+    .tx_power = 6, // 100mW
+};
+
+s32 Channels[NUM_OUT_CHANNELS];
+
+struct Telemetry Telemetry;
+
+// deviation telemetry index -> telemetry value store, -1 = not stored
+static const s8 telemetry_map[TELEM_VALUE_COUNT] = {
+    [0]                    = -1,
+    [TELEM_FRSKY_VOLT1]    = TELEMETRY_VALUE_A1,
+    [TELEM_FRSKY_VOLT2]    = TELEMETRY_VALUE_A2,
+    [TELEM_FRSKY_VOLT3]    = TELEMETRY_VALUE_VOLTAGE,
+    [TELEM_FRSKY_TEMP1]    = TELEMETRY_VALUE_TEMP1,
+    [TELEM_FRSKY_TEMP2]    = TELEMETRY_VALUE_TEMP2,
+    [TELEM_FRSKY_RPM]      = TELEMETRY_VALUE_RPM,
+    [TELEM_FRSKY_RSSI]     = TELEMETRY_VALUE_RSSI,
+    [TELEM_FRSKY_LQI]      = TELEMETRY_VALUE_LQI,
+    [TELEM_FRSKY_CELL1]    = -1,
+    [TELEM_FRSKY_CELL2]    = -1,
+    [TELEM_FRSKY_CELL3]    = -1,
+    [TELEM_FRSKY_CELL4]    = -1,
+    [TELEM_FRSKY_CELL5]    = -1,
+    [TELEM_FRSKY_CELL6]    = -1,
+    [TELEM_FRSKY_ALL_CELL] = -1,
+};
+
+void TELEMETRY_SetUpdated(int idx)
+{
+    Telemetry.updated |= (1 << idx);
+
+    // the a7105 protocols feed the same store as the frsky link
+    if ((idx >= 0) && (idx < TELEM_VALUE_COUNT) && (telemetry_map[idx] >= 0))
+        telemetry_set_value(telemetry_map[idx], Telemetry.value[idx]);
+}
+
+u32 CLOCK_getms(void)
+{
+    return timeout_get_ms();
+}
+
+void CLOCK_ResetWatchdog(void)
+{
+    wdt_reset();
+}
+
+void MCU_SerialNumber(u8 *var, int len)
+{
+    /* 96bit unique device id */
+    u32 uid[3] = { DESIG_UNIQUE_ID0, DESIG_UNIQUE_ID1, DESIG_UNIQUE_ID2 };
+    int i;
+    for (i = 0; i < len; i++)
+        var[i] = (i < 12) ? (uid[i / 4] >> (8 * (i % 4))) & 0xff : 0;
+}
+
+u32 Crc(const void *buffer, u32 size)
+{
+    return crc16((uint8_t *)buffer, size);
+}
+
+/* 32bit galois lfsr, update is shifted in bit by bit */
+u32 rand32_r(u32 *seed, u8 update)
+{
+    static u32 _seed = 0xb2c54a2f;
+    int i;
+    if (! seed)
+        seed = &_seed;
+    for (i = 0; i < 8; i++) {
+        u32 lsb = (*seed ^ update) & 1;
+        *seed >>= 1;
+        if (lsb)
+            *seed ^= 0xedb88320;
+        update >>= 1;
+    }
+    return *seed;
+}
@@ -0,0 +1,159 @@
+/*
+ This project is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ Deviation is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Deviation.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Minimal subset of the deviation environment the protocol drivers
+ * expect (model, channels, telemetry, clock and misc helpers)
+ */
+
+#ifndef _COMMON_H_
+#define _COMMON_H_
+
+#include <string.h>
+#include <stdlib.h>
+#include "interface.h"
+#include "storage.h"
+
+#define _tr_noop(x) x
+#define ctassert(COND, MSG) typedef char static_assertion_##MSG[(COND) ? 1 : -1]
+
+#define FLASHBYTETABLE static const u8
+#define pgm_read_byte(addr) (*(const u8 *)(addr))
+
+// deviation debug output of the drivers is not routed anywhere
+#define PROTO_DEBUG(...)
+
+/* Model */
+#define NUM_OUT_CHANNELS 16
+#define NUM_PROTO_OPTS    8
+
+// channel values are scaled so that +/-100% = +/-CHAN_MAX_VALUE
+#define CHAN_MULTIPLIER 100
+#define CHAN_MAX_VALUE (100 * CHAN_MULTIPLIER)
+
+enum {
+    CH_FAILSAFE_EN = 0x04,
+};
+
+struct Limit {
+    u8 flags;
+    s8 failsafe;
+};
+
+struct Model {
+    u32 fixed_id;
+    u8 num_channels;
+    u8 tx_power;
+    s16 proto_opts[NUM_PROTO_OPTS];
+    struct Limit limits[NUM_OUT_CHANNELS];
+};
+
+extern struct Model Model;
+extern s32 Channels[NUM_OUT_CHANNELS];
+
+/* Telemetry */
+enum {
+    PROTO_TELEM_UNSUPPORTED = -1,
+    PROTO_TELEM_OFF = 0,
+    PROTO_TELEM_ON = 1,
+};
+
+enum {
+    TELEM_DEVO,
+    TELEM_DSM,
+    TELEM_FRSKY,
+};
+
+// the value index is shared by all telemetry types
+enum {
+    TELEM_DEVO_VOLT1 = 1,
+    TELEM_DEVO_VOLT2,
+    TELEM_DEVO_VOLT3,
+    TELEM_DEVO_TEMP1,
+    TELEM_DEVO_TEMP2,
+    TELEM_DEVO_RPM1,
+    TELEM_DEVO_LAST,
+};
+
+enum {
+    TELEM_FRSKY_VOLT1 = 1,
+    TELEM_FRSKY_VOLT2,
+    TELEM_FRSKY_VOLT3,
+    TELEM_FRSKY_TEMP1,
+    TELEM_FRSKY_TEMP2,
+    TELEM_FRSKY_RPM,
+    TELEM_FRSKY_RSSI,
+    TELEM_FRSKY_LQI,
+    TELEM_FRSKY_CELL1,
+    TELEM_FRSKY_CELL2,
+    TELEM_FRSKY_CELL3,
+    TELEM_FRSKY_CELL4,
+    TELEM_FRSKY_CELL5,
+    TELEM_FRSKY_CELL6,
+    TELEM_FRSKY_ALL_CELL,
+    TELEM_FRSKY_LAST,
+};
+
+#define TELEM_VALUE_COUNT TELEM_FRSKY_LAST
+
+struct Telemetry {
+    s32 value[TELEM_VALUE_COUNT];
+    u32 updated;
+};
+
+extern struct Telemetry Telemetry;
+void TELEMETRY_SetUpdated(int idx);
+
+/* Clock */
+// histogram bucket n counts values below (CLOCK_HIST_FIRST_US << n) us,
+// the last bucket everything above
+#define CLOCK_HIST_BUCKETS   8
+#define CLOCK_HIST_FIRST_US 16
+
+struct ClockStats {
+    u16 exec_hist[CLOCK_HIST_BUCKETS];
+    u16 late_hist[CLOCK_HIST_BUCKETS];
+    u16 exec_max;
+    u16 late_max;
+    u16 overruns;
+    u16 deferred;
+};
+
+void CLOCK_Init(void);
+u32 CLOCK_getms(void);
+u32 CLOCK_getus(void);
+void CLOCK_StartTimer(unsigned us, u16 (*cb)(void));
+void CLOCK_StopTimer(void);
+void CLOCK_GetStats(struct ClockStats *stats);
+void CLOCK_ResetStats(void);
+void CLOCK_ResetWatchdog(void);
+void CLOCK_RunMixer(void);
+
+/* Protocol */
+int PROTOCOL_Init(u8 proto);
+void PROTOCOL_DeInit(void);
+const char *PROTOCOL_GetName(u8 proto);
+void PROTOCOL_SetBindState(u32 msec);
+int PROTOCOL_Binding(void);
+
+/* Misc */
+void MCU_SerialNumber(u8 *var, int len);
+u32 Crc(const void *buffer, u32 size);
+u32 rand32_r(u32 *seed, u8 update);
+
+// per transmitter data used to derive a default id
+#define Transmitter storage
+
+#endif  // _COMMON_H_
@@ -13,8 +13,10 @@
  along with Deviation.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-//#include "common.h"
+#include "common.h"
 #include "interface.h"
+#include "packet_pool.h"
+#include "register_image.h"
 //#include "mixer.h"
 //#include "config/model.h"
 //#include "config/tx.h"
@@ -51,10 +53,16 @@ ctassert(LAST_PROTO_OPT <= NUM_PROTO_OPTS, too_many_protocol_opts);
 #define WLTOYS_EXT_CX20 4
 
 FLASHBYTETABLE A7105_regs[] = {
-    0xFF, 0x42, 0x00, 0x14, 0x00, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x01, 0x21, 0x05, 0x00, 0x50,
-    0x9e, 0x4b, 0x00, 0x02, 0x16, 0x2b, 0x12, 0x00, 0x62, 0x80, 0x80, 0x00, 0x0a, 0x32, 0xc3, 0x0f,
-    0x13, 0xc3, 0x00, 0xFF, 0x00, 0x00, 0x3b, 0x00, 0x17, 0x47, 0x80, 0x03, 0x01, 0x45, 0x18, 0x00,
-    0x01, 0x0f, 0xFF,
+    REGISTER_IMAGE_RUN(0x01, 4),
+        0x42, 0x00, 0x14, 0x00,
+    REGISTER_IMAGE_RUN(0x07, 28),
+        0x00, 0x00, 0x00, 0x00, 0x01, 0x21, 0x05, 0x00, 0x50,
+        0x9e, 0x4b, 0x00, 0x02, 0x16, 0x2b, 0x12, 0x00, 0x62, 0x80, 0x80, 0x00, 0x0a, 0x32, 0xc3, 0x0f,
+        0x13, 0xc3, 0x00,
+    REGISTER_IMAGE_RUN(0x24, 14),
+        0x00, 0x00, 0x3b, 0x00, 0x17, 0x47, 0x80, 0x03, 0x01, 0x45, 0x18, 0x00,
+        0x01, 0x0f,
+    REGISTER_IMAGE_END
 };
 FLASHBYTETABLE tx_channels[8][4] = {
     { 0x12, 0x34, 0x56, 0x78},
@@ -113,7 +121,8 @@ enum {
 };
 
 static u32 id;
-static u8 packet[21];
+// held from the packet pool while the protocol is active
+static u8 *packet;
 static u16 counter;
 static u16 packet_period;
 static u8 hopping_frequency[16];
@@ -123,23 +132,16 @@ static s16 freq_offset;
 
 static int flysky_init()
 {
-    int i;
     u8 if_calibration1;
     u8 vco_calibration0;
     u8 vco_calibration1;
-    u8 reg;
 
     A7105_WriteID(0x5475c52a);
-    for (i = 0; i < 0x33; i++)
-    {
-        reg = pgm_read_byte(&A7105_regs[i]);
-        if(Model.proto_opts[PROTOOPTS_WLTOYS] == WLTOYS_EXT_CX20) {
-            if(i==0x0E) reg=0x01;
-            if(i==0x1F) reg=0x1F;
-            if(i==0x20) reg=0x1E;
-        }
-        if( reg != 0xFF)
-            A7105_WriteReg(i, reg);
+    A7105_WriteRegisterImage(A7105_regs);
+    if(Model.proto_opts[PROTOOPTS_WLTOYS] == WLTOYS_EXT_CX20) {
+        A7105_WriteReg(0x0E, 0x01);
+        A7105_WriteReg(0x1F, 0x1F);
+        A7105_WriteReg(0x20, 0x1E);
     }
     A7105_Strobe(A7105_STANDBY);
 
@@ -349,12 +351,18 @@ static u16 flysky_cb()
     return packet_period;
 }
 
-static void initialize(u8 bind) {
+static int initialize(u8 bind) {
     uint8_t chanrow;
     uint8_t chanoffset;
     uint8_t temp;
 
     CLOCK_StopTimer();
+    if (! packet) {
+        packet_buffer_t *buf = packet_pool_alloc(PACKET_OWNER_BUILDER);
+        if (! buf)
+            return 0;
+        packet = buf->data;
+    }
     if(Model.proto_opts[PROTOOPTS_WLTOYS] == WLTOYS_EXT_CX20) {
         packet_period = PACKET_PERIOD_CX20;
     } else {
@@ -416,18 +424,25 @@ static void initialize(u8 bind) {
     }
     
     CLOCK_StartTimer(2400, flysky_cb);
+    return 1;
 }
 
 uintptr_t FLYSKY_Cmds(enum ProtoCmds cmd)
 {
     switch(cmd) {
-        case PROTOCMD_INIT:  initialize(0); return 0;
+        case PROTOCMD_INIT:  return initialize(0) ? 0 : -1;
         case PROTOCMD_DEINIT:
+            CLOCK_StopTimer();
+            if (packet) {
+                packet_pool_free(PACKET_POOL_FROM_DATA(packet));
+                packet = NULL;
+            }
+            return (A7105_Reset() ? 1 : -1);
         case PROTOCMD_RESET:
             CLOCK_StopTimer();
             return (A7105_Reset() ? 1 : -1);
         case PROTOCMD_CHECK_AUTOBIND: return Model.fixed_id ? 0 : 1;
-        case PROTOCMD_BIND:  initialize(1); return 0;
+        case PROTOCMD_BIND:  return initialize(1) ? 0 : -1;
         case PROTOCMD_NUMCHAN: return 12;
         case PROTOCMD_DEFAULT_NUMCHAN: return 8;
         case PROTOCMD_CURRENT_ID: return id;
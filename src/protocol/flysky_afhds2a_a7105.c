@@ -13,8 +13,10 @@
  along with Deviation.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-//#include "common.h"
+#include "common.h"
 #include "interface.h"
+#include "packet_pool.h"
+#include "register_image.h"
 // #include "mixer.h"
 // #include "config/model.h"
 // #include "config/tx.h"
@@ -28,7 +30,8 @@
 #define TXID_SIZE     4
 #define RXID_SIZE     4
 
-static u8 packet[TXPACKET_SIZE];
+// held from the packet pool while the protocol is active
+static u8 *packet;
 static u8 txid[TXID_SIZE];
 static u8 rxid[RXID_SIZE];
 static u8 hopping_frequency[NUMFREQ];
@@ -41,10 +44,19 @@ static u8 tx_power;
 static s16 freq_offset;
 
 static const u8 AFHDS2A_regs[] = {
-    -1  , 0x42 | (1<<5), 0x00, 0x25, 0x00,   -1,   -1, 0x00, 0x00, 0x00, 0x00, 0x01, 0x3c, 0x05, 0x00, 0x50, // 00 - 0f
-    0x9e, 0x4b, 0x00, 0x02, 0x16, 0x2b, 0x12, 0x4f, 0x62, 0x80,   -1,   -1, 0x2a, 0x32, 0xc3, 0x1f, // 10 - 1f
-    0x1e,   -1, 0x00,   -1, 0x00, 0x00, 0x3b, 0x00, 0x17, 0x47, 0x80, 0x03, 0x01, 0x45, 0x18, 0x00, // 20 - 2f
-    0x01, 0x0f // 30 - 31
+    REGISTER_IMAGE_RUN(0x01, 4),
+        0x42 | (1<<5), 0x00, 0x25, 0x00, // 01 - 04
+    REGISTER_IMAGE_RUN(0x07, 19),
+        0x00, 0x00, 0x00, 0x00, 0x01, 0x3c, 0x05, 0x00, 0x50, // 07 - 0f
+        0x9e, 0x4b, 0x00, 0x02, 0x16, 0x2b, 0x12, 0x4f, 0x62, 0x80, // 10 - 19
+    REGISTER_IMAGE_RUN(0x1c, 5),
+        0x2a, 0x32, 0xc3, 0x1f, 0x1e, // 1c - 20
+    REGISTER_IMAGE_RUN(0x22, 1),
+        0x00, // 22
+    REGISTER_IMAGE_RUN(0x24, 14),
+        0x00, 0x00, 0x3b, 0x00, 0x17, 0x47, 0x80, 0x03, 0x01, 0x45, 0x18, 0x00, // 24 - 2f
+        0x01, 0x0f, // 30 - 31
+    REGISTER_IMAGE_END
 };
 
 enum{
@@ -92,15 +104,12 @@ ctassert(LAST_PROTO_OPT <= NUM_PROTO_OPTS, too_many_protocol_opts);
 
 static int afhds2a_init()
 {
-    u8 i;
     u8 if_calibration1;
     u8 vco_calibration0;
     u8 vco_calibration1;
 
     A7105_WriteID(0x5475c52a);
-    for (i = 0; i < sizeof(AFHDS2A_regs); i++)
-        if((s8)AFHDS2A_regs[i] != -1)
-            A7105_WriteReg(i, AFHDS2A_regs[i]);
+    A7105_WriteRegisterImage(AFHDS2A_regs);
 
     A7105_Strobe(A7105_STANDBY);
     A7105_SetTxRxMode(TX_EN);
@@ -443,12 +452,12 @@ static void initialize_tx_id()
 #ifndef USE_FIXED_MFGID
     u8 var[12];
     MCU_SerialNumber(var, 12);
-    printf("Manufacturer id: ");
+    PROTO_DEBUG("Manufacturer id: ");
     for (int i = 0; i < 12; ++i) {
-        printf("%02X", var[i]);
+        PROTO_DEBUG("%02X", var[i]);
         rand32_r(&lfsr, var[i]);
     }
-    printf("\r\n");
+    PROTO_DEBUG("\r\n");
 #endif
 
     if (Model.fixed_id) {
@@ -588,9 +597,15 @@ static u16 afhds2a_cb()
     return 3850; // never reached, please the compiler
 }
 
-static void initialize(u8 bind)
+static int initialize(u8 bind)
 {
     CLOCK_StopTimer();
+    if (! packet) {
+        packet_buffer_t *buf = packet_pool_alloc(PACKET_OWNER_BUILDER);
+        if (! buf)
+            return 0;
+        packet = buf->data;
+    }
     while(1) {
         A7105_Reset();
         CLOCK_ResetWatchdog();
@@ -614,18 +629,25 @@ static void initialize(u8 bind)
     }
     channel = 0;
     CLOCK_StartTimer(50000, afhds2a_cb);
+    return 1;
 }
 
 uintptr_t AFHDS2A_Cmds(enum ProtoCmds cmd)
 {
     switch(cmd) {
-        case PROTOCMD_INIT:  initialize(0); return 0;
+        case PROTOCMD_INIT:  return initialize(0) ? 0 : -1;
         case PROTOCMD_DEINIT:
+            CLOCK_StopTimer();
+            if (packet) {
+                packet_pool_free(PACKET_POOL_FROM_DATA(packet));
+                packet = NULL;
+            }
+            return (A7105_Reset() ? 1 : -1);
         case PROTOCMD_RESET:
             CLOCK_StopTimer();
             return (A7105_Reset() ? 1 : -1);
         case PROTOCMD_CHECK_AUTOBIND: return 0;
-        case PROTOCMD_BIND:  initialize(1); return 0;
+        case PROTOCMD_BIND:  return initialize(1) ? 0 : -1;
         case PROTOCMD_NUMCHAN: return 14;
         case PROTOCMD_DEFAULT_NUMCHAN: return 8;
         case PROTOCMD_CURRENT_ID: return Model.fixed_id;
@@ -20,11 +20,12 @@
 #endif
 #include "common.h"
 #include "interface.h"
-#include "mixer.h"
-#include "config/model.h"
+#include "packet_pool.h"
+// #include "mixer.h"
+// #include "config/model.h"
 #include <string.h>
 #include <stdlib.h>
-#include "telemetry.h"
+// #include "telemetry.h"
 
 #ifdef EMULATOR
 #define USE_FIXED_MFGID
@@ -149,7 +150,8 @@ enum {
 #define ID_NORMAL 0x55201041 // H102D, H107/L/C/D, H301, H501S
 #define ID_PLUS   0xAA201041 // H107P/C+/D+
 
-static u8 packet[16];
+// held from the packet pool while the protocol is active
+static u8 *packet;
 static u8 channel;
 static s16 vtx_freq;
 static const u8 allowed_ch[] = {0x14, 0x1e, 0x28, 0x32, 0x3c, 0x46, 0x50, 0x5a, 0x64, 0x6e, 0x78, 0x82};
@@ -605,8 +607,14 @@ static u16 hubsan_cb()
     return 0;
 }
 
-static void initialize(u8 bind) {
+static int initialize(u8 bind) {
     CLOCK_StopTimer();
+    if (! packet) {
+        packet_buffer_t *buf = packet_pool_alloc(PACKET_OWNER_BUILDER);
+        if (! buf)
+            return 0;
+        packet = buf->data;
+    }
     while(1) {
         A7105_Reset();
         CLOCK_ResetWatchdog();
@@ -648,18 +656,25 @@ static void initialize(u8 bind) {
     if( Model.proto_opts[PROTOOPTS_VTX_FREQ] == 0)
         Model.proto_opts[PROTOOPTS_VTX_FREQ] = 5885;
     CLOCK_StartTimer(10000, hubsan_cb);
+    return 1;
 }
 
 uintptr_t HUBSAN_Cmds(enum ProtoCmds cmd)
 {
     switch(cmd) {
-        case PROTOCMD_INIT: initialize(0); return 0;
+        case PROTOCMD_INIT: return initialize(0) ? 0 : -1;
         case PROTOCMD_DEINIT:
+            CLOCK_StopTimer();
+            if (packet) {
+                packet_pool_free(PACKET_POOL_FROM_DATA(packet));
+                packet = NULL;
+            }
+            return (A7105_Reset() ? 1 : -1);
         case PROTOCMD_RESET:
             CLOCK_StopTimer();
             return (A7105_Reset() ? 1 : -1);
         case PROTOCMD_CHECK_AUTOBIND: return Model.proto_opts[PROTOOPTS_FORMAT] == FORMAT_H107;
-        case PROTOCMD_BIND:  initialize(1); return 0;
+        case PROTOCMD_BIND:  return initialize(1) ? 0 : -1;
         case PROTOCMD_NUMCHAN: return 13;  // A, E, T, R, Leds, Flips(or alt-hold), Snapshot, Video Recording, Headless, RTH, GPS Hold, Mode, flip
         case PROTOCMD_DEFAULT_NUMCHAN: return 13;
         case PROTOCMD_CURRENT_ID: return 0;
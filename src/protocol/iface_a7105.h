@@ -73,6 +73,7 @@ enum A7105_MASK {
 };
 
 void A7105_WriteReg(u8 addr, u8 value);
+void A7105_WriteRegisterImage(const u8 *image);
 void A7105_WriteData(u8 *dpbuffer, u8 len, u8 channel);
 void A7105_ReadData(u8 *dpbuffer, u8 len);
 u8 A7105_ReadReg(u8 addr);
@@ -82,5 +83,7 @@ void A7105_Strobe(enum A7105_State);
 void A7105_SetPower(int power);
 void A7105_SetTxRxMode(enum TXRX_State);
 void A7105_AdjustLOBaseFreq(s16 offset);
+u32 A7105_GetSpiBytesSaved(void);
+u32 A7105_GetSpiBytesSavedPerSecond(void);
 
 #endif
@@ -21,10 +21,11 @@
 
 #include "common.h"
 #include "interface.h"
-#include "mixer.h"
-#include "config/model.h"
-#include "config/tx.h"
-#include "telemetry.h"
+#include "register_image.h"
+// #include "mixer.h"
+// #include "config/model.h"
+// #include "config/tx.h"
+// #include "telemetry.h"
 
 #ifdef MODULAR
   #pragma long_calls_off
@@ -36,10 +37,18 @@
 #define EVEN_ODD 0x00
 //#define EVEN_ODD 0x01
 static const u8 A7105_regs[] = {
-    0x00, 0x62,   -1, 0x0f, 0x00,  -1 ,  -1 , 0x00,     0x00, 0x05, 0x00, 0x01, 0x00, 0xf5, 0x00, 0x15,
-    0x9e, 0x4b, 0x00, 0x03, 0x56, 0x2b, 0x12, 0x4a,     0x02, 0x80, 0x80, 0x00, 0x0e, 0x91, 0x03, 0x0f,
-    0x16, 0x2a, 0x00,  -1,    -1,   -1, 0x3a, 0x06,     0x1f, 0x47, 0x80, 0x01, 0x05, 0x45, 0x18, 0x00,
-    0x01, 0x0f, 0x00
+    REGISTER_IMAGE_RUN(0x00, 2),
+        0x00, 0x62,
+    REGISTER_IMAGE_RUN(0x03, 2),
+        0x0f, 0x00,
+    REGISTER_IMAGE_RUN(0x07, 28),
+        0x00,     0x00, 0x05, 0x00, 0x01, 0x00, 0xf5, 0x00, 0x15,
+        0x9e, 0x4b, 0x00, 0x03, 0x56, 0x2b, 0x12, 0x4a,     0x02, 0x80, 0x80, 0x00, 0x0e, 0x91, 0x03, 0x0f,
+        0x16, 0x2a, 0x00,
+    REGISTER_IMAGE_RUN(0x26, 13),
+        0x3a, 0x06,     0x1f, 0x47, 0x80, 0x01, 0x05, 0x45, 0x18, 0x00,
+        0x01, 0x0f, 0x00,
+    REGISTER_IMAGE_END
 };
 
 static u32 id;
@@ -63,7 +72,6 @@ ctassert(LAST_PROTO_OPT <= NUM_PROTO_OPTS, too_many_protocol_opts);
 
 static int joysway_init()
 {
-    int i;
     u8 if_calibration1;
     //u8 vco_calibration0;
     //u8 vco_calibration1;
@@ -71,9 +79,7 @@ static int joysway_init()
     counter = 0;
     next_ch = 0x30;
 
-    for (i = 0; i < 0x33; i++)
-        if((s8)A7105_regs[i] != -1)
-            A7105_WriteReg(i, A7105_regs[i]);
+    A7105_WriteRegisterImage(A7105_regs);
     A7105_WriteID(0x5475c52a);
 
     A7105_Strobe(A7105_PLL);
@@ -13,6 +13,7 @@
  along with Deviation.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "common.h"
 #include "interface.h"
 #include <stdlib.h>
 
@@ -26,3 +27,61 @@ const struct{
     #include "protocol.h"
 };
 #undef PROTODEF
+
+static u8 current_protocol;
+static u32 bind_time;
+
+/* returns 0 if the protocol could not be started */
+int PROTOCOL_Init(u8 proto)
+{
+    PROTOCOL_DeInit();
+    if (proto == PROTOCOL_NONE || proto >= PROTOCOL_COUNT)
+        return 0;
+    current_protocol = proto;
+    if ((intptr_t)Protocols[proto].cmd(PROTOCMD_INIT) < 0) {
+        /* e.g. no packet buffer left */
+        PROTOCOL_DeInit();
+        return 0;
+    }
+    return 1;
+}
+
+const char *PROTOCOL_GetName(u8 proto)
+{
+    if (proto >= PROTOCOL_COUNT)
+        proto = PROTOCOL_NONE;
+    return Protocols[proto].name;
+}
+
+void PROTOCOL_DeInit(void)
+{
+    if (current_protocol == PROTOCOL_NONE)
+        return;
+    Protocols[current_protocol].cmd(PROTOCMD_DEINIT);
+    CLOCK_StopTimer();
+    current_protocol = PROTOCOL_NONE;
+}
+
+void PROTOCOL_SetBindState(u32 msec)
+{
+    if (msec) {
+        if (msec == 0xFFFFFFFF)
+            bind_time = msec;
+        else
+            bind_time = CLOCK_getms() + msec;
+    } else {
+        bind_time = 0;
+    }
+}
+
+int PROTOCOL_Binding(void)
+{
+    if (bind_time) {
+        if (bind_time == 0xFFFFFFFF)
+            return -1;
+        if (CLOCK_getms() < bind_time)
+            return 1;
+        bind_time = 0;
+    }
+    return 0;
+}
@@ -1,9 +1,15 @@
 #ifndef _PROTOSPI_H
 #define _PROTOSPI_H
 
+#include "interface.h"
+
+void SPI_ProtoInit(void);
 void PROTO_CS_LO(u8 radio);
 void PROTO_CS_HI(u8 radio);
 void PROTOSPI_xfer(u8 byte);
 u8 PROTOSPI_read3wire(void);
+void PROTOSPI_xfer_block(const u8 *data, u8 len);
+u8 PROTOSPI_read3wire_block(u8 *data, u8 len);
+void PROTOSPI_txrx(enum TXRX_State mode);
 
 #endif
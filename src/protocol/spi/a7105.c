@@ -18,6 +18,34 @@
 #include "timeout.h"
 #include "protocol/interface.h"
 #include "protocol/protospi.h"
+#include "register_image.h"
+#include <string.h>
+#include <libopencm3/cm3/cortex.h>
+
+/*
+ * Write-through shadow of the control registers. Writes of unchanged
+ * values are skipped. The control registers do not auto increment,
+ * so there is nothing to gain from batching them.
+ */
+#define SHADOW_SIZE (A7105_32_FILTER_TEST + 1)
+static u8 shadow[SHADOW_SIZE];
+static u8 shadow_valid[(SHADOW_SIZE + 7) / 8];
+static volatile u32 shadow_saved;
+static u32 shadow_rate_ms;
+static u32 shadow_rate_saved;
+
+static int shadow_cacheable(u8 address)
+{
+    switch (address) {
+        case A7105_00_MODE:      // reset
+        case A7105_02_CALC:      // self clearing calibration trigger
+        case A7105_05_FIFO_DATA: // data ports
+        case A7105_06_ID_DATA:
+            return 0;
+        default:
+            return address < SHADOW_SIZE;
+    }
+}
 
 static void CS_HI(void) {
     PROTO_CS_HI(A7105);
@@ -29,10 +57,61 @@ static void CS_LO(void) {
 
 void A7105_WriteReg(u8 address, u8 data)
 {
+    int cacheable = shadow_cacheable(address);
+    /* the protocol timer isr shares the shadow with the main loop */
+    u32 primask = cm_mask_interrupts(1);
+    if (cacheable && (shadow_valid[address >> 3] & (1 << (address & 7))) && shadow[address] == data) {
+        shadow_saved += 2;
+        cm_mask_interrupts(primask);
+        return;
+    }
+    cm_mask_interrupts(primask);
+
     CS_LO();
     PROTOSPI_xfer(address);
     PROTOSPI_xfer(data);
     CS_HI();
+
+    primask = cm_mask_interrupts(1);
+    if (address == A7105_00_MODE) {
+        /* software reset, all registers are back to their defaults */
+        memset(shadow_valid, 0, sizeof(shadow_valid));
+    } else if (cacheable) {
+        shadow[address] = data;
+        shadow_valid[address >> 3] |= 1 << (address & 7);
+    }
+    cm_mask_interrupts(primask);
+}
+
+u32 A7105_GetSpiBytesSaved(void)
+{
+    return shadow_saved;
+}
+
+/* average over the time since the last call */
+u32 A7105_GetSpiBytesSavedPerSecond(void)
+{
+    u32 now = timeout_get_ms();
+    u32 saved = shadow_saved;
+    u32 elapsed = now - shadow_rate_ms;
+    u32 rate = 0;
+    if (elapsed)
+        rate = ((saved - shadow_rate_saved) * 1000) / elapsed;
+    shadow_rate_ms = now;
+    shadow_rate_saved = saved;
+    return rate;
+}
+
+void A7105_WriteRegisterImage(const u8 *image)
+{
+    /* Control registers do not auto increment, one frame per register */
+    while (REGISTER_IMAGE_RUN_LENGTH(image)) {
+        u8 address = REGISTER_IMAGE_RUN_ADDRESS(image);
+        const u8 *data = REGISTER_IMAGE_RUN_DATA(image);
+        for (int i = 0; i < REGISTER_IMAGE_RUN_LENGTH(image); i++)
+            A7105_WriteReg(address + i, data[i]);
+        image = REGISTER_IMAGE_NEXT_RUN(image);
+    }
 }
 
 u8 A7105_ReadReg(u8 address)
@@ -48,12 +127,10 @@ u8 A7105_ReadReg(u8 address)
 
 void A7105_WriteData(u8 *dpbuffer, u8 len, u8 channel)
 {
-    int i;
     CS_LO();
     PROTOSPI_xfer(A7105_RST_WRPTR);
     PROTOSPI_xfer(0x05);
-    for (i = 0; i < len; i++)
-        PROTOSPI_xfer(dpbuffer[i]);
+    PROTOSPI_xfer_block(dpbuffer, len);
     CS_HI();
 
     A7105_WriteReg(0x0F, channel);
@@ -65,9 +142,10 @@ void A7105_WriteData(u8 *dpbuffer, u8 len, u8 channel)
 void A7105_ReadData(u8 *dpbuffer, u8 len)
 {
     A7105_Strobe(A7105_RST_RDPTR);
-    for(int i = 0; i < len; i++)
-        dpbuffer[i] = A7105_ReadReg(0x05);
-    return;
+    CS_LO();
+    PROTOSPI_xfer(0x40 | 0x05);
+    PROTOSPI_read3wire_block(dpbuffer, len);
+    CS_HI();
 }
 
 /*
@@ -75,6 +153,7 @@ void A7105_ReadData(u8 *dpbuffer, u8 len)
  */
 void A7105_SetTxRxMode(enum TXRX_State mode)
 {
+    PROTOSPI_txrx(mode);
     if(mode == TX_EN) {
         A7105_WriteReg(A7105_0B_GPIO1_PIN1, 0x33);
         A7105_WriteReg(A7105_0C_GPIO2_PIN_II, 0x31);
@@ -0,0 +1,209 @@
+/*
+ This project is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ Deviation is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Deviation.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "protocol/interface.h"
+#include "protocol/protospi.h"
+#include "config.h"
+
+#include <libopencm3/stm32/rcc.h>
+#include <libopencm3/stm32/gpio.h>
+#include <libopencm3/stm32/spi.h>
+#include <libopencm3/stm32/dma.h>
+
+/* upper bound for busy waits, a 38 byte burst takes ~100us at 3MHz */
+#define PROTOSPI_TIMEOUT 20000
+
+static void wait_tx_done(void)
+{
+    u32 timeout = PROTOSPI_TIMEOUT;
+    while (!(SPI_SR(A7105_SPI) & SPI_SR_TXE) && --timeout)
+        ;
+    while ((SPI_SR(A7105_SPI) & SPI_SR_BSY) && --timeout)
+        ;
+}
+
+static void wait_dma_done(u8 channel)
+{
+    u32 timeout = PROTOSPI_TIMEOUT;
+    while (!dma_get_interrupt_flag(DMA1, channel, DMA_TCIF) && --timeout)
+        ;
+    dma_disable_channel(DMA1, channel);
+    dma_clear_interrupt_flags(DMA1, channel, DMA_TCIF);
+}
+
+static void flush_rx(void)
+{
+    /* the receiver runs in bidirectional transmit mode as well */
+    while (SPI_SR(A7105_SPI) & SPI_SR_RXNE)
+        (void)SPI_DR(A7105_SPI);
+}
+
+static void init_dma_channel(u8 channel)
+{
+    dma_channel_reset(DMA1, channel);
+    dma_set_memory_size(DMA1, channel, DMA_CCR_MSIZE_8BIT);
+    dma_set_peripheral_size(DMA1, channel, DMA_CCR_PSIZE_8BIT);
+    dma_enable_memory_increment_mode(DMA1, channel);
+    dma_disable_peripheral_increment_mode(DMA1, channel);
+    dma_set_peripheral_address(DMA1, channel, (u32)&(SPI_DR(A7105_SPI)));
+    dma_set_priority(DMA1, channel, DMA_CCR_PL_HIGH);
+}
+
+void SPI_ProtoInit(void)
+{
+    rcc_periph_clock_enable(GPIO_RCC(A7105_SPI_GPIO));
+    rcc_periph_clock_enable(GPIO_RCC(A7105_SPI_CS_GPIO));
+    rcc_periph_clock_enable(A7105_SPI_CLK);
+    rcc_periph_clock_enable(RCC_DMA);
+
+    /* CS is driven by software */
+    gpio_mode_setup(A7105_SPI_CS_GPIO, GPIO_MODE_OUTPUT, GPIO_PUPD_NONE, A7105_SPI_CS_PIN);
+    gpio_set_output_options(A7105_SPI_CS_GPIO, GPIO_OTYPE_PP, GPIO_OSPEED_50MHZ, A7105_SPI_CS_PIN);
+    gpio_set(A7105_SPI_CS_GPIO, A7105_SPI_CS_PIN);
+
+    /* pa and lna switch of the module, both off */
+    rcc_periph_clock_enable(GPIO_RCC(A7105_TXW_GPIO));
+    rcc_periph_clock_enable(GPIO_RCC(A7105_RXW_GPIO));
+    gpio_mode_setup(A7105_TXW_GPIO, GPIO_MODE_OUTPUT, GPIO_PUPD_NONE, A7105_TXW_PIN);
+    gpio_mode_setup(A7105_RXW_GPIO, GPIO_MODE_OUTPUT, GPIO_PUPD_NONE, A7105_RXW_PIN);
+    PROTOSPI_txrx(TXRX_OFF);
+
+    /* SCK and the bidirectional SDIO line (MOSI) */
+    gpio_mode_setup(A7105_SPI_GPIO, GPIO_MODE_AF, GPIO_PUPD_NONE,
+                    A7105_SPI_SCK_PIN | A7105_SPI_SDIO_PIN);
+    gpio_set_output_options(A7105_SPI_GPIO, GPIO_OTYPE_PP, GPIO_OSPEED_50MHZ,
+                            A7105_SPI_SCK_PIN | A7105_SPI_SDIO_PIN);
+    gpio_set_af(A7105_SPI_GPIO, GPIO_AF1, A7105_SPI_SCK_PIN | A7105_SPI_SDIO_PIN);
+
+    /* 3MHz, mode 0, 3-wire */
+    spi_reset(A7105_SPI);
+    spi_init_master(A7105_SPI,
+                    SPI_CR1_BAUDRATE_FPCLK_DIV_8,
+                    SPI_CR1_CPOL_CLK_TO_0_WHEN_IDLE,
+                    SPI_CR1_CPHA_CLK_TRANSITION_1,
+                    SPI_CR1_CRCL_8BIT,
+                    SPI_CR1_MSBFIRST);
+    spi_enable_software_slave_management(A7105_SPI);
+    spi_set_nss_high(A7105_SPI);
+    spi_set_bidirectional_transmit_only_mode(A7105_SPI);
+    spi_fifo_reception_threshold_8bit(A7105_SPI);
+
+    /* burst transfers, completion is polled */
+    init_dma_channel(A7105_SPI_TX_DMA_CHANNEL);
+    dma_set_read_from_memory(DMA1, A7105_SPI_TX_DMA_CHANNEL);
+    init_dma_channel(A7105_SPI_RX_DMA_CHANNEL);
+    dma_set_read_from_peripheral(DMA1, A7105_SPI_RX_DMA_CHANNEL);
+
+    spi_enable(A7105_SPI);
+}
+
+void PROTO_CS_LO(u8 radio)
+{
+    (void)radio;
+    gpio_clear(A7105_SPI_CS_GPIO, A7105_SPI_CS_PIN);
+}
+
+void PROTO_CS_HI(u8 radio)
+{
+    (void)radio;
+    /* make sure the last byte left the shift register */
+    wait_tx_done();
+    gpio_set(A7105_SPI_CS_GPIO, A7105_SPI_CS_PIN);
+}
+
+void PROTOSPI_xfer(u8 byte)
+{
+    spi_send8(A7105_SPI, byte);
+    wait_tx_done();
+}
+
+u8 PROTOSPI_read3wire(void)
+{
+    u8 data;
+    wait_tx_done();
+    spi_disable(A7105_SPI);
+    spi_set_bidirectional_receive_only_mode(A7105_SPI);
+    flush_rx();
+    spi_enable(A7105_SPI);  //This starts the data read
+    //Wait > 1 SPI clock (but less than 8).  clock is 3MHz
+    asm volatile ("nop\n\tnop\n\tnop\n\tnop\n\tnop\n\tnop\n\tnop\n\tnop\n\tnop\n\tnop\n\tnop\n\tnop\n\tnop\n\tnop\n\tnop\n\tnop\n\tnop\n\tnop\n\tnop\n\tnop");
+    spi_disable(A7105_SPI); //This ends the read window
+    u32 timeout = PROTOSPI_TIMEOUT;
+    while (!(SPI_SR(A7105_SPI) & SPI_SR_RXNE) && --timeout)
+        ;
+    data = spi_read8(A7105_SPI);
+    spi_set_bidirectional_transmit_only_mode(A7105_SPI);
+    spi_enable(A7105_SPI);
+    return data;
+}
+
+void PROTOSPI_xfer_block(const u8 *data, u8 len)
+{
+    if (!len)
+        return;
+    wait_tx_done();
+    dma_set_memory_address(DMA1, A7105_SPI_TX_DMA_CHANNEL, (u32)data);
+    dma_set_number_of_data(DMA1, A7105_SPI_TX_DMA_CHANNEL, len);
+    dma_enable_channel(DMA1, A7105_SPI_TX_DMA_CHANNEL);
+    spi_enable_tx_dma(A7105_SPI);
+
+    wait_dma_done(A7105_SPI_TX_DMA_CHANNEL);
+    spi_disable_tx_dma(A7105_SPI);
+    wait_tx_done();
+    flush_rx();
+}
+
+u8 PROTOSPI_read3wire_block(u8 *data, u8 len)
+{
+    if (!len)
+        return 0;
+    wait_tx_done();
+    spi_disable(A7105_SPI);
+    spi_set_bidirectional_receive_only_mode(A7105_SPI);
+    flush_rx();
+
+    dma_set_memory_address(DMA1, A7105_SPI_RX_DMA_CHANNEL, (u32)data);
+    dma_set_number_of_data(DMA1, A7105_SPI_RX_DMA_CHANNEL, len);
+    dma_enable_channel(DMA1, A7105_SPI_RX_DMA_CHANNEL);
+    spi_enable_rx_dma(A7105_SPI);
+
+    /* in receive only mode the clock runs as soon as the spi is enabled */
+    spi_enable(A7105_SPI);
+    wait_dma_done(A7105_SPI_RX_DMA_CHANNEL);
+    spi_disable(A7105_SPI);
+    u8 missing = dma_get_number_of_data(DMA1, A7105_SPI_RX_DMA_CHANNEL);
+    spi_disable_rx_dma(A7105_SPI);
+
+    /* the bytes clocked in after the last one are of no interest */
+    flush_rx();
+    spi_set_bidirectional_transmit_only_mode(A7105_SPI);
+    spi_enable(A7105_SPI);
+    return len - missing;
+}
+
+void PROTOSPI_txrx(enum TXRX_State mode)
+{
+    /* the module pads RX/W and TX/W switch the external pa and lna */
+    if (mode == TX_EN) {
+        gpio_clear(A7105_RXW_GPIO, A7105_RXW_PIN);
+        gpio_set(A7105_TXW_GPIO, A7105_TXW_PIN);
+    } else if (mode == RX_EN) {
+        gpio_clear(A7105_TXW_GPIO, A7105_TXW_PIN);
+        gpio_set(A7105_RXW_GPIO, A7105_RXW_PIN);
+    } else {
+        gpio_clear(A7105_TXW_GPIO, A7105_TXW_PIN);
+        gpio_clear(A7105_RXW_GPIO, A7105_RXW_PIN);
+    }
+}
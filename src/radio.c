@@ -0,0 +1,234 @@
+/*
+    Copyright 2016 fishpepper <AT> gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    author: fishpepper <AT> gmail.com
+*/
+
+#include "radio.h"
+#include "debug.h"
+#include "frsky.h"
+#include "protocol/common.h"
+#include "protocol/protospi.h"
+#include <string.h>
+
+// the frsky link runs all the time and is the reference for the frame
+// budget. the a7105 protocol callbacks run below the frsky isrs and are
+// held back during the frsky telemetry window, see radio_guard_*. the
+// slot period and rx window follow the frsky frame rate and the cpu
+// times are replaced by the measured worst case as soon as there is
+// one, see radio_frsky_timing_update()
+static radio_timing_t radio_frsky_timing = {
+    .cpu_us       = RADIO_FRSKY_CPU_US,
+    .max_delay_us = RADIO_FRSKY_MAX_DELAY_US,
+};
+
+// shortest callback period and estimated callback runtime per protocol
+static const radio_timing_t radio_a7105_timing[PROTOCOL_COUNT] = {
+    [PROTOCOL_FLYSKY]  = { .period_us = 1510, .cpu_us = 250 },
+    [PROTOCOL_AFHDS2A] = { .period_us = 1700, .cpu_us = 350 },
+    [PROTOCOL_HUBSAN]  = { .period_us =  500, .cpu_us = 250 },
+    [PROTOCOL_JOYSWAY] = { .period_us = 6000, .cpu_us = 250 },
+    [PROTOCOL_BUGS3]   = { .period_us = 1400, .cpu_us = 300 },
+};
+
+static uint8_t radio_a7105_protocol;
+static uint8_t radio_a7105_bus_ready;
+
+// worst case callback runtime seen per protocol, 0 = not measured yet
+static uint16_t radio_a7105_cpu_max_us[PROTOCOL_COUNT];
+
+// end of the current guard window (tim2 time base)
+static volatile uint32_t radio_guard_end_us;
+static volatile uint8_t  radio_guard_active;
+
+void radio_init(void) {
+    debug("radio: init\n"); debug_flush();
+
+    radio_a7105_protocol  = PROTOCOL_NONE;
+    radio_a7105_bus_ready = 0;
+    radio_guard_active    = 0;
+    memset(radio_a7105_cpu_max_us, 0, sizeof(radio_a7105_cpu_max_us));
+}
+
+static void radio_frsky_timing_update(void) {
+    uint16_t last_us, max_us;
+
+    // the slot time and telemetry window depend on the frame rate mode
+    radio_frsky_timing.period_us = frsky_get_slot_period_us();
+    radio_frsky_timing.guard_us  = frsky_get_rx_window_us();
+
+    frsky_get_slot_timing(&last_us, &max_us);
+    radio_frsky_timing.cpu_us = max_us ? max_us : RADIO_FRSKY_CPU_US;
+}
+
+static void radio_a7105_timing_get(uint8_t protocol, radio_timing_t *timing) {
+    *timing = radio_a7105_timing[protocol];
+    if (radio_a7105_cpu_max_us[protocol]) {
+        timing->cpu_us = radio_a7105_cpu_max_us[protocol];
+    }
+}
+
+static void radio_a7105_measure(void) {
+    struct ClockStats stats;
+
+    if (radio_a7105_protocol == PROTOCOL_NONE) {
+        return;
+    }
+
+    // the clock stats are reset when a protocol starts
+    CLOCK_GetStats(&stats);
+    if (stats.exec_max > radio_a7105_cpu_max_us[radio_a7105_protocol]) {
+        radio_a7105_cpu_max_us[radio_a7105_protocol] = stats.exec_max;
+    }
+}
+
+static uint32_t radio_a7105_fits(uint8_t protocol) {
+    radio_timing_t timing;
+
+    radio_a7105_timing_get(protocol, &timing);
+    if (!frsky_is_fitted()) {
+        // no frsky link, the a7105 has the frame for itself
+        return (timing.cpu_us < timing.period_us) &&
+               (((uint32_t)timing.cpu_us * 1000) / timing.period_us <= RADIO_MAX_LOAD_PERMILLE);
+    }
+
+    radio_frsky_timing_update();
+    return radio_timing_fits(&radio_frsky_timing, &timing);
+}
+
+static uint32_t radio_a7105_bus_init(void) {
+    if (frsky_is_fitted()) {
+        // the rf pads carry the cc2500, see config.h
+        debug("radio: no a7105 module\n"); debug_flush();
+        return 0;
+    }
+
+    if (!radio_a7105_bus_ready) {
+        // the pads are switched to 3-wire spi with the first a7105 protocol
+        SPI_ProtoInit();
+        radio_a7105_bus_ready = 1;
+    }
+    return 1;
+}
+
+static uint32_t radio_delay_fits(const radio_timing_t *victim, const radio_timing_t *other) {
+    // a slot is delayed at most by one slot of the other link and its guard
+    uint32_t max_delay = victim->max_delay_us;
+    if (!max_delay) {
+        // a slot may be late as long as it is done before the next one
+        max_delay = victim->period_us - victim->cpu_us;
+    }
+    return (other->cpu_us + other->guard_us) <= max_delay;
+}
+
+// check if both links fit into the same frame budget
+uint32_t radio_timing_fits(const radio_timing_t *a, const radio_timing_t *b) {
+    if ((a->cpu_us >= a->period_us) || (b->cpu_us >= b->period_us)) {
+        return 0;
+    }
+
+    uint32_t load = ((uint32_t)a->cpu_us * 1000) / a->period_us +
+                    ((uint32_t)b->cpu_us * 1000) / b->period_us;
+    if (load > RADIO_MAX_LOAD_PERMILLE) {
+        return 0;
+    }
+
+    return radio_delay_fits(a, b) && radio_delay_fits(b, a);
+}
+
+uint32_t radio_a7105_start(uint8_t protocol) {
+    if ((protocol == PROTOCOL_NONE) || (protocol >= PROTOCOL_COUNT)) {
+        return 0;
+    }
+
+    // keep the measurement of a running protocol before it is replaced
+    radio_a7105_stop();
+
+    if (!radio_a7105_bus_init()) {
+        return 0;
+    }
+
+    if (!radio_a7105_fits(protocol)) {
+        debug("radio: a7105 protocol does not fit\n"); debug_flush();
+        return 0;
+    }
+
+    CLOCK_ResetStats();
+    if (!PROTOCOL_Init(protocol)) {
+        debug("radio: a7105 protocol init failed\n"); debug_flush();
+        return 0;
+    }
+    radio_a7105_protocol = protocol;
+    return 1;
+}
+
+void radio_a7105_stop(void) {
+    if (radio_a7105_protocol != PROTOCOL_NONE) {
+        radio_a7105_measure();
+        PROTOCOL_DeInit();
+        radio_a7105_protocol = PROTOCOL_NONE;
+    }
+}
+
+// switch to the protocol of a model, PROTOCOL_NONE turns the a7105 off
+uint32_t radio_a7105_select(uint8_t protocol) {
+    if (protocol == PROTOCOL_NONE) {
+        radio_a7105_stop();
+        return 1;
+    }
+    if (protocol == radio_a7105_protocol) {
+        return 1;
+    }
+    return radio_a7105_start(protocol);
+}
+
+// called periodically from the main loop: stop a protocol as soon as the
+// measured runtimes no longer fit next to the frsky link
+void radio_a7105_check(void) {
+    if (radio_a7105_protocol == PROTOCOL_NONE) {
+        return;
+    }
+
+    radio_a7105_measure();
+    if (!radio_a7105_fits(radio_a7105_protocol)) {
+        debug("radio: a7105 protocol overloads the frame\n"); debug_flush();
+        radio_a7105_stop();
+    }
+}
+
+uint8_t radio_a7105_get_protocol(void) {
+    return radio_a7105_protocol;
+}
+
+// called by the link that needs the air for itself
+void radio_guard_start(uint16_t us) {
+    radio_guard_end_us = CLOCK_getus() + us;
+    radio_guard_active = 1;
+}
+
+// remaining time of the guard window, 0 if the air is free
+uint32_t radio_guard_remaining(void) {
+    if (!radio_guard_active) {
+        return 0;
+    }
+
+    int32_t remaining = radio_guard_end_us - CLOCK_getus();
+    if (remaining <= 0) {
+        radio_guard_active = 0;
+        return 0;
+    }
+    return remaining;
+}
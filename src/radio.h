@@ -0,0 +1,56 @@
+/*
+    Copyright 2016 fishpepper <AT> gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    author: fishpepper <AT> gmail.com
+*/
+
+#ifndef RADIO_H_
+#define RADIO_H_
+
+#include <stdint.h>
+
+// timing budget of one link
+typedef struct {
+    // shortest time between two slots
+    uint16_t period_us;
+    // worst case isr time of one slot
+    uint16_t cpu_us;
+    // time after a slot the other link must not transmit
+    uint16_t guard_us;
+    // how late a slot may start
+    uint16_t max_delay_us;
+} radio_timing_t;
+
+// share of the cpu both links may use together
+#define RADIO_MAX_LOAD_PERMILLE  500
+
+// frsky d8: the a7105 stays quiet during the telemetry rx window,
+// the cpu time is an estimate until the first slot was measured
+#define RADIO_FRSKY_CPU_US       250
+#define RADIO_FRSKY_MAX_DELAY_US 500
+
+void radio_init(void);
+uint32_t radio_timing_fits(const radio_timing_t *a, const radio_timing_t *b);
+uint32_t radio_a7105_start(uint8_t protocol);
+void radio_a7105_stop(void);
+uint32_t radio_a7105_select(uint8_t protocol);
+void radio_a7105_check(void);
+uint8_t radio_a7105_get_protocol(void);
+
+void radio_guard_start(uint16_t us);
+uint32_t radio_guard_remaining(void);
+
+#endif  // RADIO_H_
@@ -0,0 +1,36 @@
+/*
+    Copyright 2016 fishpepper <AT> gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    author: fishpepper <AT> gmail.com
+*/
+
+#ifndef REGISTER_IMAGE_H_
+#define REGISTER_IMAGE_H_
+
+// a register image is a const (flash resident) list of register runs.
+// each run holds the address of its first register, the number of
+// consecutive registers and their values:
+//   [address, count, value 0, ..., value count-1]
+// a run with count 0 terminates the image.
+#define REGISTER_IMAGE_RUN(address, count) (address), (count)
+#define REGISTER_IMAGE_END                 0x00, 0x00
+
+#define REGISTER_IMAGE_RUN_ADDRESS(run)    ((run)[0])
+#define REGISTER_IMAGE_RUN_LENGTH(run)     ((run)[1])
+#define REGISTER_IMAGE_RUN_DATA(run)       (&(run)[2])
+#define REGISTER_IMAGE_NEXT_RUN(run)       (&(run)[2 + (run)[1]])
+
+#endif  // REGISTER_IMAGE_H_
@@ -0,0 +1,191 @@
+/*
+    Copyright 2016 fishpepper <AT> gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    author: fishpepper <AT> gmail.com
+*/
+
+#include "scanner.h"
+#include "cc2500.h"
+#include "frsky.h"
+#include "debug.h"
+#include "delay.h"
+#include "wdt.h"
+#include "radio.h"
+#include "storage.h"
+#include "protocol/common.h"
+
+// MCSM0 with and without calibration on every idle -> rx transition
+#define SCANNER_MCSM0_AUTOCAL    0x18
+#define SCANNER_MCSM0_MANUALCAL  0x08
+
+// rssi is valid this long after the rx strobe (pll settling + filter)
+#define SCANNER_SETTLE_US        200
+
+// pll calibration per bin
+static uint8_t scanner_calib_table[SCANNER_BIN_COUNT][CC2500_FSCAL_COUNT];
+
+// levels per bin, the average is q4 fixed point
+static uint8_t scanner_peak[SCANNER_BIN_COUNT];
+static uint16_t scanner_average[SCANNER_BIN_COUNT];
+
+static uint16_t scanner_sweep_time_us;
+
+// rssi read and retune of one step, run by the spi dma
+static cc2500_chain_t scanner_chain;
+static volatile uint8_t scanner_chain_busy;
+static uint8_t scanner_rssi;
+
+// internal functions
+static void scanner_calibrate(void);
+static void scanner_chain_step(uint32_t read, uint32_t next_bin);
+static void scanner_chain_done(uint32_t result);
+static void scanner_update_bin(uint8_t bin, uint8_t rssi_raw);
+
+void scanner_start(void) {
+    uint32_t i;
+
+    debug("scanner: start\n"); debug_flush();
+
+    // the a7105 protocol would transmit into the band we measure
+    radio_a7105_stop();
+
+    // the caller stopped the frsky tx isr, detach its packet callback
+    // so that nothing touches the fifo while we listen around. the d8
+    // register set stays, only the channel and calibration change
+    cc2500_set_packet_callback(0, 0);
+    cc2500_strobe(RFST_SIDLE);
+
+    for (i = 0; i < SCANNER_BIN_COUNT; i++) {
+        scanner_peak[i]    = 0;
+        scanner_average[i] = 0;
+    }
+
+    scanner_calibrate();
+}
+
+void scanner_stop(void) {
+    debug("scanner: stop\n"); debug_flush();
+
+    // bring back the frsky registers, pll cache and tx isr
+    frsky_resume();
+    radio_a7105_select(storage.model[storage.current_model].a7105_protocol);
+}
+
+static void scanner_calibrate(void) {
+    uint32_t i;
+    uint32_t timeout;
+
+    cc2500_set_register(MCSM0, SCANNER_MCSM0_AUTOCAL);
+
+    for (i = 0; i < SCANNER_BIN_COUNT; i++) {
+        frsky_tune_channel(i * SCANNER_CHANNEL_STEP);
+
+        // start calibration and wait for it to finish (takes ~720us)
+        cc2500_strobe(RFST_SCAL);
+        for (timeout = 0; timeout < 100; timeout++) {
+            delay_us(20);
+            if ((cc2500_get_register(MARCSTATE) & 0x1F) == 0x01) break;
+        }
+
+        cc2500_fscal_save(scanner_calib_table[i]);
+        wdt_reset();
+    }
+
+    // from now on tuning loads the cached calibration
+    cc2500_set_register(MCSM0, SCANNER_MCSM0_MANUALCAL);
+}
+
+// one dma chain: read the rssi of the current bin, then go to idle,
+// load the calibration of the next bin and start rx there
+static void scanner_chain_step(uint32_t read, uint32_t next_bin) {
+    cc2500_chain_reset(&scanner_chain);
+    if (read) {
+        cc2500_chain_read(&scanner_chain, RSSI, &scanner_rssi);
+    }
+    cc2500_chain_strobe(&scanner_chain, RFST_SIDLE);
+    if (next_bin < SCANNER_BIN_COUNT) {
+        cc2500_chain_burst(&scanner_chain, FSCAL3, scanner_calib_table[next_bin], CC2500_FSCAL_COUNT);
+        cc2500_chain_register(&scanner_chain, CHANNR, next_bin * SCANNER_CHANNEL_STEP);
+        cc2500_chain_strobe(&scanner_chain, RFST_SRX);
+    }
+
+    scanner_chain_busy = 1;
+    if (!cc2500_chain_start(&scanner_chain, scanner_chain_done)) {
+        // queue full, this reading is lost
+        scanner_chain_busy = 0;
+    }
+}
+
+static void scanner_chain_done(uint32_t UNUSED(result)) {
+    scanner_chain_busy = 0;
+}
+
+void scanner_sweep(void) {
+    uint32_t bin;
+    uint32_t tuned_us;
+    uint32_t start_us = CLOCK_getus();
+    uint8_t last_rssi = 0;
+
+    scanner_chain_step(0, 0);
+    while (scanner_chain_busy) {}
+    tuned_us = CLOCK_getus();
+
+    for (bin = 0; bin < SCANNER_BIN_COUNT; bin++) {
+        while ((CLOCK_getus() - tuned_us) < SCANNER_SETTLE_US) {
+        }
+
+        // the dma reads bin n and tunes to bin n+1,
+        // meanwhile the reading of bin n-1 is processed
+        scanner_chain_step(1, bin + 1);
+        if (bin) {
+            scanner_update_bin(bin - 1, last_rssi);
+        }
+        while (scanner_chain_busy) {}
+        tuned_us = CLOCK_getus();
+        last_rssi = scanner_rssi;
+    }
+    scanner_update_bin(SCANNER_BIN_COUNT - 1, last_rssi);
+
+    scanner_sweep_time_us = CLOCK_getus() - start_us;
+}
+
+static void scanner_update_bin(uint8_t bin, uint8_t rssi_raw) {
+    // rssi is in 0.5dB steps (two's complement) with an offset of 72dB
+    int16_t level = ((int8_t)rssi_raw) / 2 - 72 + 110;
+
+    if (level < 0) level = 0;
+    if (level > SCANNER_LEVEL_MAX) level = SCANNER_LEVEL_MAX;
+
+    // running peak with a slow decay, moving average
+    if (level >= scanner_peak[bin]) {
+        scanner_peak[bin] = level;
+    } else {
+        scanner_peak[bin]--;
+    }
+    scanner_average[bin] += ((int16_t)(level << 4) - (int16_t)scanner_average[bin]) >> 3;
+}
+
+uint8_t scanner_get_peak(uint8_t bin) {
+    return scanner_peak[bin % SCANNER_BIN_COUNT];
+}
+
+uint8_t scanner_get_average(uint8_t bin) {
+    return scanner_average[bin % SCANNER_BIN_COUNT] >> 4;
+}
+
+uint16_t scanner_get_sweep_time_us(void) {
+    return scanner_sweep_time_us;
+}
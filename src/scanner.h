@@ -0,0 +1,39 @@
+/*
+    Copyright 2016 fishpepper <AT> gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    author: fishpepper <AT> gmail.com
+*/
+
+#ifndef SCANNER_H_
+#define SCANNER_H_
+
+#include <stdint.h>
+
+// one bin every second cc2500 channel (~600kHz), 2404...2480MHz
+#define SCANNER_BIN_COUNT     128
+#define SCANNER_CHANNEL_STEP  2
+// levels are dB above -110dBm
+#define SCANNER_LEVEL_MAX     80
+
+void scanner_start(void);
+void scanner_stop(void);
+void scanner_sweep(void);
+
+uint8_t scanner_get_peak(uint8_t bin);
+uint8_t scanner_get_average(uint8_t bin);
+uint16_t scanner_get_sweep_time_us(void);
+
+#endif  // SCANNER_H_
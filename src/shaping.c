@@ -0,0 +1,118 @@
+/*
+    Copyright 2016 fishpepper <AT> gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    author: fishpepper <AT> gmail.com
+*/
+
+#include "shaping.h"
+#include "storage.h"
+#include "adc.h"
+#include "debug.h"
+#include "macros.h"
+
+// lookup tables in Q15, double buffered as the mixer isr may run
+// while a new model is compiled
+static int16_t shaping_lut[2][SHAPING_CHANNEL_COUNT][SHAPING_LUT_POINTS];
+static volatile uint8_t shaping_lut_index;
+
+// internal functions
+static int32_t shaping_deadband(int32_t x, uint8_t deadband);
+static int32_t shaping_expo(int32_t x, uint8_t expo);
+static int32_t shaping_curve(int32_t x, const int8_t *curve);
+
+void shaping_init(void) {
+    debug("shaping: init\n"); debug_flush();
+
+    shaping_lut_index = 0;
+    shaping_compile();
+}
+
+// all helpers work on Q15 values, +/-32768 = +/-100%
+static int32_t shaping_deadband(int32_t x, uint8_t deadband) {
+    int32_t band = ((int32_t)min(deadband, 99) * 32768) / 100;
+    int32_t mag  = (x < 0) ? -x : x;
+
+    if (mag <= band) {
+        return 0;
+    }
+
+    // stretch the remaining travel to full range
+    mag = ((mag - band) * 32768) / (32768 - band);
+    return (x < 0) ? -mag : mag;
+}
+
+static int32_t shaping_expo(int32_t x, uint8_t expo) {
+    int32_t k  = ((int32_t)min(expo, 100) * 32768) / 100;
+    int32_t x3 = (((x * x) >> 15) * x) >> 15;
+
+    // y = (1 - k) * x + k * x^3
+    return (((32768 - k) * x) >> 15) + ((k * x3) >> 15);
+}
+
+static int32_t shaping_curve(int32_t x, const int8_t *curve) {
+    // curve points are spread evenly over -100% ... +100%
+    int32_t span = 65536 / (STORAGE_CURVE_POINTS - 1);
+    int32_t pos  = x + 32768;
+    int32_t seg  = min(pos / span, STORAGE_CURVE_POINTS - 2);
+    int32_t frac = pos - seg * span;
+
+    int32_t y0 = ((int32_t)curve[seg] * 32768) / 100;
+    int32_t y1 = ((int32_t)curve[seg + 1] * 32768) / 100;
+    return y0 + ((y1 - y0) * frac) / span;
+}
+
+// build the lookup tables for the current model. the divisions here
+// only run on model load or when a setting changed
+void shaping_compile(void) {
+    uint32_t i, j;
+    uint8_t next = shaping_lut_index ^ 1;
+    MODEL_DESC *model = &storage.model[storage.current_model];
+
+    for (i = 0; i < SHAPING_CHANNEL_COUNT; i++) {
+        MODEL_SHAPING_DESC *shaping = &model->shaping[i];
+
+        for (j = 0; j < SHAPING_LUT_POINTS; j++) {
+            int32_t x = -32768 + (int32_t)j * (65536 / SHAPING_LUT_SEGMENTS);
+            x = shaping_deadband(x, shaping->deadband);
+            x = shaping_expo(x, shaping->expo);
+            x = shaping_curve(x, shaping->curve);
+            shaping_lut[next][i][j] = max(-SHAPING_OUTPUT_MAX, min(SHAPING_OUTPUT_MAX, x));
+        }
+    }
+
+    // publish
+    shaping_lut_index = next;
+}
+
+// shape a rescaled stick value (+/-3200), returns +/-SHAPING_OUTPUT_MAX
+int32_t shaping_apply(uint8_t channel, int32_t value) {
+    // 0 ... 6400 -> 0 ... 32 segments with 10 bit fraction,
+    // 5243 / 1024 ~ (32 << 10) / 6400
+    uint32_t pos = ((uint32_t)(value + ADC_RESCALED_ABSOLUTE_MAX) * 5243) >> 10;
+    uint32_t seg  = pos >> 10;
+    uint32_t frac = pos & 0x3FF;
+
+    if (channel >= SHAPING_CHANNEL_COUNT) {
+        return (value * SHAPING_OUTPUT_MAX) / ADC_RESCALED_ABSOLUTE_MAX;
+    }
+
+    int16_t *lut = shaping_lut[shaping_lut_index][channel];
+    if (seg >= SHAPING_LUT_SEGMENTS) {
+        return lut[SHAPING_LUT_SEGMENTS];
+    }
+
+    return lut[seg] + (((lut[seg + 1] - lut[seg]) * (int32_t)frac) >> 10);
+}
@@ -0,0 +1,37 @@
+/*
+    Copyright 2016 fishpepper <AT> gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    author: fishpepper <AT> gmail.com
+*/
+
+#ifndef SHAPING_H_
+#define SHAPING_H_
+
+#include <stdint.h>
+
+// deadband, expo and curve of the sticks are compiled into one
+// interpolated lookup table per channel (input and output +/-100%)
+#define SHAPING_CHANNEL_COUNT  4
+#define SHAPING_LUT_SEGMENTS   32
+#define SHAPING_LUT_POINTS     (SHAPING_LUT_SEGMENTS + 1)
+// output of shaping_apply(): +/-100% = +/-SHAPING_OUTPUT_MAX (Q15)
+#define SHAPING_OUTPUT_MAX     32767
+
+void shaping_init(void);
+void shaping_compile(void);
+int32_t shaping_apply(uint8_t channel, int32_t value);
+
+#endif  // SHAPING_H_
@@ -23,17 +23,57 @@
 #include "led.h"
 #include "config.h"
 #include "cc2500.h"
+#include "assert.h"
 
 #include <libopencm3/stm32/rcc.h>
 #include <libopencm3/stm32/gpio.h>
 #include <libopencm3/stm32/spi.h>
 #include <libopencm3/stm32/dma.h>
+#include <libopencm3/cm3/cortex.h>
 
 // internal functions
 static void spi_init_gpio(void);
 static void spi_init_mode(void);
 static void spi_init_dma(void);
 static void spi_init_rcc(void);
+static void spi_dma_start(const uint8_t *tx_data, uint8_t *rx_data, uint8_t len);
+static void spi_chain_start_transaction(void);
+static void spi_chain_advance(void);
+static void spi_chain_finish(uint32_t result);
+static void spi_chain_begin(spi_transaction_t *chain, uint8_t count, spi_callback_t callback);
+static void spi_queue_start_next(void);
+
+// transaction chain processed by the dma isr
+static spi_transaction_t *spi_chain;
+static uint8_t spi_chain_count;
+static uint8_t spi_chain_index;
+static uint8_t spi_chain_phase;
+static spi_callback_t spi_chain_callback;
+static volatile uint8_t spi_chain_busy;
+
+// chains waiting for the running one, started by the dma isr
+typedef struct {
+    spi_transaction_t *chain;
+    uint8_t count;
+    spi_callback_t callback;
+} spi_queue_entry_t;
+static spi_queue_entry_t spi_queue[SPI_XFER_QUEUE_SIZE];
+static volatile uint8_t spi_queue_head;
+static volatile uint8_t spi_queue_count;
+static volatile uint32_t spi_queue_full_count;
+
+// set while the main loop talks to the chip without dma,
+// chains requested by the isrs meanwhile are queued
+static volatile uint8_t spi_bus_locked;
+
+#define SPI_CHAIN_PHASE_HEADER  0
+#define SPI_CHAIN_PHASE_PAYLOAD 1
+
+// used when a transaction has no tx or rx buffer
+static const uint8_t spi_dummy_tx = 0xFF;
+static uint8_t spi_dummy_rx;
+
+static volatile uint32_t spi_timeout_count;
 
 
 void spi_init(void) {
@@ -104,9 +144,9 @@ static void spi_init_dma(void) {
     // enable DMA1 Peripheral Clock
     rcc_periph_clock_enable(RCC_DMA);
 
-    // DMA NVIC
+    // DMA NVIC, rx completion drives the transaction chain
     nvic_set_priority(NVIC_DMA1_CHANNEL2_3_IRQ, NVIC_PRIO_FRSKY);
-    // nvic_enable_irq(NVIC_DMA1_CHANNEL2_3_IRQ); // NO IRQ beeing used here
+    nvic_enable_irq(NVIC_DMA1_CHANNEL2_3_IRQ);
 
     // start with clean init for RX channel
     dma_channel_reset(DMA1, CC2500_SPI_RX_DMA_CHANNEL);
@@ -127,6 +167,8 @@ static void spi_init_dma(void) {
     dma_set_number_of_data(DMA1, CC2500_SPI_RX_DMA_CHANNEL, 1);
     // very high prio
     dma_set_priority(DMA1, CC2500_SPI_RX_DMA_CHANNEL, DMA_CCR_PL_VERY_HIGH);
+    // the last received byte marks the end of a transfer
+    dma_enable_transfer_complete_interrupt(DMA1, CC2500_SPI_RX_DMA_CHANNEL);
 
     // start with clean init for TX channel
     dma_channel_reset(DMA1, CC2500_SPI_TX_DMA_CHANNEL);
@@ -158,32 +200,254 @@ static void spi_init_dma(void) {
 void spi_dma_xfer(uint8_t *buffer, uint8_t len) {
     // debug("xfer "); debug_put_uint8(len); debug(")\n");
 
-    // TX: transfer buffer to slave
-    dma_set_memory_address(DMA1, CC2500_SPI_TX_DMA_CHANNEL, (uint32_t)buffer);
+    // the caller selected the chip with the bus locked, no chain runs
+    assert(spi_bus_locked && !spi_chain_busy);
+
+    // transfer buffer to slave and read back into the same buffer
+    spi_dma_start(buffer, buffer, len);
+
+    // wait for completion
+    while (!(SPI_SR(CC2500_SPI) & SPI_SR_TXE)) {}
+    while (SPI_SR(CC2500_SPI) & SPI_SR_BSY) {}
+
+    // disable DMA
+    dma_disable_channel(DMA1, CC2500_SPI_RX_DMA_CHANNEL);
+    dma_disable_channel(DMA1, CC2500_SPI_TX_DMA_CHANNEL);
+}
+
+
+uint32_t spi_wait_miso_ready(void) {
+    // the cc2500 pulls miso low as soon as its crystal is running,
+    // never wait forever on a missing or stuck chip
+    uint32_t timeout = SPI_MISO_READY_TIMEOUT;
+
+    while (gpio_get(CC2500_SPI_GPIO, CC2500_SPI_MISO_PIN)) {
+        if (--timeout == 0) {
+            spi_timeout_count++;
+            return 0;
+        }
+    }
+    return 1;
+}
+
+uint32_t spi_get_timeout_count(void) {
+    return spi_timeout_count;
+}
+
+uint32_t spi_xfer_async(spi_transaction_t *chain, uint8_t count, spi_callback_t callback) {
+    uint32_t result = 1;
+
+    if (count == 0) {
+        return 0;
+    }
+
+    // called from the main loop and from isrs
+    uint32_t primask = cm_mask_interrupts(1);
+
+    if (!spi_chain_busy && !spi_bus_locked) {
+        // the remaining transactions are started from the dma isr
+        spi_chain_begin(chain, count, callback);
+    } else if (spi_queue_count < SPI_XFER_QUEUE_SIZE) {
+        // started as soon as the running chain is done
+        spi_queue_entry_t *entry = &spi_queue[(spi_queue_head + spi_queue_count) % SPI_XFER_QUEUE_SIZE];
+        entry->chain    = chain;
+        entry->count    = count;
+        entry->callback = callback;
+        spi_queue_count++;
+    } else {
+        spi_queue_full_count++;
+        result = 0;
+    }
+
+    cm_mask_interrupts(primask);
+
+    return result;
+}
+
+uint32_t spi_get_queue_full_count(void) {
+    return spi_queue_full_count;
+}
+
+static void spi_chain_begin(spi_transaction_t *chain, uint8_t count, spi_callback_t callback) {
+    spi_chain          = chain;
+    spi_chain_count    = count;
+    spi_chain_index    = 0;
+    spi_chain_callback = callback;
+    spi_chain_busy     = 1;
+
+    spi_chain_start_transaction();
+}
+
+uint32_t spi_xfer_busy(void) {
+    // queued chains do not run while the bus is locked
+    return spi_chain_busy || (spi_queue_count && !spi_bus_locked);
+}
+
+void spi_xfer_wait(void) {
+    // never call this from isr context, queued chains are waited for as well
+    while (spi_xfer_busy()) {
+        // our caller might run with the same or a higher priority than the
+        // dma isr, thus advance the chain by polling the completion flag
+        nvic_disable_irq(NVIC_DMA1_CHANNEL2_3_IRQ);
+        if (spi_chain_busy && dma_get_interrupt_flag(DMA1, CC2500_SPI_RX_DMA_CHANNEL, DMA_TCIF)) {
+            dma_clear_interrupt_flags(DMA1, CC2500_SPI_RX_DMA_CHANNEL, DMA_TCIF);
+            spi_chain_advance();
+        }
+        nvic_enable_irq(NVIC_DMA1_CHANNEL2_3_IRQ);
+    }
+}
+
+// the rf pads carry another module, its driver takes over spi and dma
+void spi_release(void) {
+    spi_xfer_wait();
+    nvic_disable_irq(NVIC_DMA1_CHANNEL2_3_IRQ);
+    spi_disable_rx_dma(CC2500_SPI);
+    spi_disable_tx_dma(CC2500_SPI);
+}
+
+void spi_bus_lock(void) {
+    // main loop only: wait for the dma, then keep the bus for us
+    while (1) {
+        spi_xfer_wait();
+
+        uint32_t primask = cm_mask_interrupts(1);
+        if (!spi_chain_busy) {
+            spi_bus_locked = 1;
+            cm_mask_interrupts(primask);
+            return;
+        }
+        // an isr was faster, try again
+        cm_mask_interrupts(primask);
+    }
+}
+
+void spi_bus_unlock(void) {
+    uint32_t primask = cm_mask_interrupts(1);
+
+    spi_bus_locked = 0;
+
+    if (!spi_chain_busy) {
+        // run what the isrs queued meanwhile
+        spi_queue_start_next();
+    }
+
+    cm_mask_interrupts(primask);
+}
+
+static void spi_dma_start(const uint8_t *tx_data, uint8_t *rx_data, uint8_t len) {
+    // TX: a missing buffer clocks out 0xFF
+    if (tx_data) {
+        dma_enable_memory_increment_mode(DMA1, CC2500_SPI_TX_DMA_CHANNEL);
+        dma_set_memory_address(DMA1, CC2500_SPI_TX_DMA_CHANNEL, (uint32_t)tx_data);
+    } else {
+        dma_disable_memory_increment_mode(DMA1, CC2500_SPI_TX_DMA_CHANNEL);
+        dma_set_memory_address(DMA1, CC2500_SPI_TX_DMA_CHANNEL, (uint32_t)&spi_dummy_tx);
+    }
     dma_set_number_of_data(DMA1, CC2500_SPI_TX_DMA_CHANNEL, len);
 
-    // RX: read back data from slave
-    dma_set_memory_address(DMA1, CC2500_SPI_RX_DMA_CHANNEL, (uint32_t)buffer);
+    // RX: a missing buffer discards the data read back
+    if (rx_data) {
+        dma_enable_memory_increment_mode(DMA1, CC2500_SPI_RX_DMA_CHANNEL);
+        dma_set_memory_address(DMA1, CC2500_SPI_RX_DMA_CHANNEL, (uint32_t)rx_data);
+    } else {
+        dma_disable_memory_increment_mode(DMA1, CC2500_SPI_RX_DMA_CHANNEL);
+        dma_set_memory_address(DMA1, CC2500_SPI_RX_DMA_CHANNEL, (uint32_t)&spi_dummy_rx);
+    }
     dma_set_number_of_data(DMA1, CC2500_SPI_RX_DMA_CHANNEL, len);
 
-    // enable both dma channels
+    // rx has to be enabled first
     dma_enable_channel(DMA1, CC2500_SPI_RX_DMA_CHANNEL);
     dma_enable_channel(DMA1, CC2500_SPI_TX_DMA_CHANNEL);
 
-    // trigger the SPI TX + RX dma
-    spi_enable_tx_dma(CC2500_SPI);
     spi_enable_rx_dma(CC2500_SPI);
+    spi_enable_tx_dma(CC2500_SPI);
+}
 
+static void spi_chain_start_transaction(void) {
+    spi_transaction_t *transaction = &spi_chain[spi_chain_index];
 
-    // wait for completion
-    while (!(SPI_SR(CC2500_SPI) & SPI_SR_TXE)) {}
-    while (SPI_SR(CC2500_SPI) & SPI_SR_BSY) {}
+    if (transaction->action) {
+        // e.g. switch the pa/lna path in between two transactions
+        transaction->action();
+    }
+
+    // select device
+    spi_csn_lo();
+
+    if (!spi_wait_miso_ready()) {
+        // chip did not respond, abort the whole chain
+        spi_csn_hi();
+        spi_chain_finish(SPI_XFER_TIMEOUT);
+        return;
+    }
+
+    // header first, the chip returns its status byte meanwhile
+    spi_chain_phase = SPI_CHAIN_PHASE_HEADER;
+    spi_dma_start(&transaction->header, &transaction->status, 1);
+}
+
+static void spi_chain_advance(void) {
+    spi_transaction_t *transaction = &spi_chain[spi_chain_index];
 
-    // disable DMA
     dma_disable_channel(DMA1, CC2500_SPI_RX_DMA_CHANNEL);
     dma_disable_channel(DMA1, CC2500_SPI_TX_DMA_CHANNEL);
+
+    if ((spi_chain_phase == SPI_CHAIN_PHASE_HEADER) && (transaction->len)) {
+        // header is out, continue with the payload
+        spi_chain_phase = SPI_CHAIN_PHASE_PAYLOAD;
+        spi_dma_start(transaction->tx_data, transaction->rx_data, transaction->len);
+        return;
+    }
+
+    // transaction done, deselect device
+    spi_csn_hi();
+
+    spi_chain_index++;
+    if (spi_chain_index < spi_chain_count) {
+        spi_chain_start_transaction();
+    } else {
+        spi_chain_finish(SPI_XFER_OK);
+    }
+}
+
+static void spi_chain_finish(uint32_t result) {
+    spi_callback_t callback = spi_chain_callback;
+
+    spi_chain_busy = 0;
+
+    // keep the bus busy, chains queued by the callback go behind this one
+    spi_queue_start_next();
+
+    if (callback) {
+        callback(result);
+    }
+}
+
+static void spi_queue_start_next(void) {
+    if (!spi_queue_count) {
+        return;
+    }
+
+    spi_queue_entry_t *entry = &spi_queue[spi_queue_head];
+    spi_queue_head = (spi_queue_head + 1) % SPI_XFER_QUEUE_SIZE;
+    spi_queue_count--;
+    spi_chain_begin(entry->chain, entry->count, entry->callback);
 }
 
+void DMA1_Channel2_3_IRQHandler(void) {
+    if (dma_get_interrupt_flag(DMA1, CC2500_SPI_RX_DMA_CHANNEL, DMA_TCIF)) {
+        dma_clear_interrupt_flags(DMA1, CC2500_SPI_RX_DMA_CHANNEL, DMA_TCIF);
+
+        // blocking transfers see the same flag, ignore them here
+        if (spi_chain_busy) {
+            spi_chain_advance();
+        }
+    }
+
+    if (dma_get_interrupt_flag(DMA1, CC2500_SPI_TX_DMA_CHANNEL, DMA_TCIF)) {
+        dma_clear_interrupt_flags(DMA1, CC2500_SPI_TX_DMA_CHANNEL, DMA_TCIF);
+    }
+}
 
 static void spi_init_gpio(void) {
     // init sck, mosi and miso
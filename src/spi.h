@@ -25,8 +25,45 @@
 #include "config.h"
 #include "delay.h"
 
+// one transaction: csn low, header byte, payload, csn high
+typedef struct {
+    // address or command byte
+    uint8_t header;
+    // status byte returned by the chip during the header
+    uint8_t status;
+    // payload length, may be zero
+    uint8_t len;
+    // payload source, null clocks out 0xFF
+    const uint8_t *tx_data;
+    // destination for the bytes read back, null discards them
+    uint8_t *rx_data;
+    // optional, called from the dma isr right before csn goes low
+    void (*action)(void);
+} spi_transaction_t;
+
+#define SPI_XFER_OK       0
+#define SPI_XFER_TIMEOUT  1
+
+// called from the dma isr once the chain is done
+typedef void (*spi_callback_t)(uint32_t result);
+
+// chains started while another one is running are queued
+#define SPI_XFER_QUEUE_SIZE 4
+
+// maximum number of polls while waiting for the cc2500 to pull miso low
+#define SPI_MISO_READY_TIMEOUT 5000
+
 void spi_init(void);
 void spi_dma_xfer(uint8_t *buffer, uint8_t len);
+uint32_t spi_xfer_async(spi_transaction_t *chain, uint8_t count, spi_callback_t callback);
+uint32_t spi_xfer_busy(void);
+void spi_xfer_wait(void);
+void spi_bus_lock(void);
+void spi_bus_unlock(void);
+uint32_t spi_wait_miso_ready(void);
+uint32_t spi_get_timeout_count(void);
+uint32_t spi_get_queue_full_count(void);
+void spi_release(void);
 #define spi_csn_lo() { gpio_clear(CC2500_SPI_GPIO, CC2500_SPI_CSN_PIN); delay_us(1); }
 #define spi_csn_hi() { delay_us(1); gpio_set(CC2500_SPI_GPIO, CC2500_SPI_CSN_PIN); }
 uint8_t spi_tx(uint8_t data);
@@ -26,6 +26,8 @@
 #include "eeprom.h"
 #include "hoptable.h"
 #include "crc16.h"
+#include "mixer.h"
+#include "protocol/interface.h"
 
 // internal functions
 static uint8_t  storage_is_valid(void);
@@ -124,7 +126,7 @@ static uint16_t storage_calc_crc(void) {
 }
 
 static void storage_load_defaults(void) {
-    uint8_t i;
+    uint8_t i, j, k;
 
     debug("storage: reading defaults\n"); debug_flush();
 
@@ -162,6 +164,29 @@ static void storage_load_defaults(void) {
         storage.model[i].name[6] = 0;
         storage.model[i].timer = 3*60;
         storage.model[i].stick_scale = 100;
+        storage.model[i].frsky_rate = FRSKY_RATE_STANDARD;
+        storage.model[i].mixer_lead = MIXER_LEAD_TIME_DEFAULT_US / MIXER_LEAD_TIME_STEP_US;
+        storage.model[i].a7105_protocol = PROTOCOL_NONE;
+
+        // linear, no deadband
+        for (j = 0; j < STORAGE_SHAPING_COUNT; j++) {
+            storage.model[i].shaping[j].deadband = 0;
+            storage.model[i].shaping[j].expo = 0;
+            for (k = 0; k < STORAGE_CURVE_POINTS; k++) {
+                storage.model[i].shaping[j].curve[k] =
+                        -100 + (k * 200) / (STORAGE_CURVE_POINTS - 1);
+            }
+        }
+
+        // no mixes, outputs follow the inputs
+        for (j = 0; j < STORAGE_MIX_COUNT; j++) {
+            storage.model[i].mix[j].source = MIXER_SOURCE_NONE;
+            storage.model[i].mix[j].destination = 0;
+            storage.model[i].mix[j].weight = 100;
+            storage.model[i].mix[j].offset = 0;
+            storage.model[i].mix[j].sw = MIXER_SWITCH_ALWAYS;
+            storage.model[i].mix[j].mode = MIXER_MODE_ADD;
+        }
     }
 
     // add example model
@@ -23,10 +23,15 @@
 #include <stdint.h>
 
 #include "frsky.h"
+#include "mixer.h"
 
-#define STORAGE_VERSION_ID 0x03
+#define STORAGE_VERSION_ID 0x04
 #define STORAGE_MODEL_NAME_LEN 11
 #define STORAGE_MODEL_MAX_COUNT 10
+// sticks with deadband/expo/curve settings and points per curve
+#define STORAGE_SHAPING_COUNT 4
+#define STORAGE_CURVE_POINTS 5
+#define STORAGE_MIX_COUNT 6
 
 void storage_init(void);
 // static void storage_init_memory(void);
@@ -38,6 +43,31 @@ void storage_mode_set_name(uint8_t index, char *str);
 /*static void storage_write(uint8_t *buffer, uint16_t len);
 static void storage_read(uint8_t *storage_ptr, uint16_t len);*/
 
+// input shaping of one stick
+typedef struct {
+    // deadband around center in percent
+    uint8_t deadband;
+    // expo in percent, 0 = linear
+    uint8_t expo;
+    // curve output in percent at -100%, -50%, 0%, 50%, 100% input
+    int8_t curve[STORAGE_CURVE_POINTS];
+} MODEL_SHAPING_DESC;
+
+// one mix: destination (mode) source * weight + offset
+typedef struct {
+    // input, see MIXER_SOURCE_*. MIXER_SOURCE_NONE = unused
+    uint8_t source;
+    // output channel
+    uint8_t destination;
+    // weight and offset in percent
+    int8_t weight;
+    int8_t offset;
+    // see MIXER_SWITCH_*
+    uint8_t sw;
+    // see MIXER_MODE_*
+    uint8_t mode;
+} MODEL_MIX_DESC;
+
 // model description
 typedef struct {
     // name of the model
@@ -46,6 +76,16 @@ typedef struct {
     uint16_t timer;
     // scale
     uint8_t stick_scale;
+    // frsky frame rate mode, see FRSKY_RATE_*
+    uint8_t frsky_rate;
+    // mixer lead time before each rf slot, in MIXER_LEAD_TIME_STEP_US
+    uint8_t mixer_lead;
+    // protocol of the a7105 module, PROTOCOL_NONE when unused
+    uint8_t a7105_protocol;
+    // per stick input shaping, AETR
+    MODEL_SHAPING_DESC shaping[STORAGE_SHAPING_COUNT];
+    // mixes, applied in order
+    MODEL_MIX_DESC mix[STORAGE_MIX_COUNT];
     // add further data here...
 } MODEL_DESC;
 
@@ -20,6 +20,9 @@
 #include "telemetry.h"
 #include "debug.h"
 #include "fifo.h"
+#include "timeout.h"
+
+#include <libopencm3/cm3/cortex.h>
 
 // telemetry fifo size, has to be a power of 2 !
 #define TELEMETRY_BUFFER_LENGTH 64
@@ -33,25 +36,82 @@ static uint8_t telemetry_low_byte;
 static uint16_t telemetry_last_value;
 static uint8_t  telemetry_last_id;
 
-static uint16_t telemetry_decoded_data_voltage;
-static uint16_t telemetry_decoded_data_current;
-static uint16_t telemetry_decoded_data_mah;
+// value store, written from isrs and the main loop. every update sets
+// the sensor bit in the dirty bitmap of each reader
+static telemetry_value_t telemetry_values[TELEMETRY_VALUE_COUNT];
+static volatile uint32_t telemetry_dirty[TELEMETRY_READER_COUNT];
+
+// smartport frame assembly
+static uint8_t telemetry_sport_active;
+static uint8_t telemetry_sport_stuffed;
+static uint8_t telemetry_sport_index;
+static uint8_t telemetry_sport_frame[1 + TELEMETRY_SPORT_FRAME_LEN];
+
+// hub ids (protocol_sensor_hub.pdf), anything not listed is ignored.
+// the ampere sensor voltage (0x3a/0x3b) is split and handled in code
+static const telemetry_sensor_t telemetry_hub_sensors[] = {
+    { 0x02, 0x02, TELEMETRY_VALUE_TEMP1,    TELEMETRY_SENSOR_SIGNED16, 1 },
+    { 0x03, 0x03, TELEMETRY_VALUE_RPM,      0, 1 },
+    // betaflight sends capacity in mah (default)
+    { 0x04, 0x04, TELEMETRY_VALUE_MAH,      0, 1 },
+    { 0x05, 0x05, TELEMETRY_VALUE_TEMP2,    TELEMETRY_SENSOR_SIGNED16, 1 },
+    { 0x10, 0x10, TELEMETRY_VALUE_ALTITUDE, TELEMETRY_SENSOR_SIGNED16, 100 },
+    { 0x28, 0x28, TELEMETRY_VALUE_CURRENT,  0, 10 },
+    { 0x30, 0x30, TELEMETRY_VALUE_VARIO,    TELEMETRY_SENSOR_SIGNED16, 1 },
+    { 0x39, 0x39, TELEMETRY_VALUE_VOLTAGE,  0, 10 },
+};
+
+// smartport app ids, each sensor type owns a range of 16 instances
+static const telemetry_sensor_t telemetry_sport_sensors[] = {
+    { 0x0100, 0x010F, TELEMETRY_VALUE_ALTITUDE, 0, 1 },
+    { 0x0110, 0x011F, TELEMETRY_VALUE_VARIO,    0, 1 },
+    { 0x0200, 0x020F, TELEMETRY_VALUE_CURRENT,  0, 10 },
+    { 0x0210, 0x021F, TELEMETRY_VALUE_VOLTAGE,  0, 1 },
+    { 0x0400, 0x040F, TELEMETRY_VALUE_TEMP1,    0, 1 },
+    { 0x0410, 0x041F, TELEMETRY_VALUE_TEMP2,    0, 1 },
+    { 0x0500, 0x050F, TELEMETRY_VALUE_RPM,      0, 1 },
+    { 0x0600, 0x060F, TELEMETRY_VALUE_MAH,      0, 1 },
+    { 0xF101, 0xF101, TELEMETRY_VALUE_RSSI,     0, 1 },
+    { 0xF102, 0xF102, TELEMETRY_VALUE_A1,       0, 1 },
+    { 0xF103, 0xF103, TELEMETRY_VALUE_A2,       0, 1 },
+};
+
+#define TELEMETRY_TABLE_SIZE(_t) ((uint8_t)(sizeof(_t) / sizeof(_t[0])))
+
+// bytes dropped because the fifo was full
+static volatile uint32_t telemetry_overflow_count;
 
 // internal functions
 static void telemetry_parse_stream(uint8_t byte);
 static void telemetry_process_hub_packet(uint8_t id, uint16_t value);
+static void telemetry_parse_sport(uint8_t byte);
+static void telemetry_process_sport_frame(const uint8_t *frame);
+static const telemetry_sensor_t *telemetry_find_sensor(const telemetry_sensor_t *table,
+                                                       uint8_t count, uint16_t id);
+static void telemetry_store(const telemetry_sensor_t *sensor, int32_t value);
 
 void telemetry_init(void) {
+    uint32_t i;
+
     debug("telemetry: init\n"); debug_flush();
 
     telemetry_state = TELEMETRY_IDLE;
-    telemetry_decoded_data_voltage = 0;
-    telemetry_decoded_data_current = 0;
+    for (i = 0; i < TELEMETRY_VALUE_COUNT; i++) {
+        telemetry_values[i].value        = 0;
+        telemetry_values[i].min          = 0;
+        telemetry_values[i].max          = 0;
+        telemetry_values[i].timestamp_ms = 0;
+    }
+    for (i = 0; i < TELEMETRY_READER_COUNT; i++) {
+        telemetry_dirty[i] = 0;
+    }
+    telemetry_sport_active = 0;
     telemetry_last_value = 0;
     telemetry_data_id = 0;
     telemetry_last_id = 0;
     telemetry_high_byte = 0;
     telemetry_low_byte = 0;
+    telemetry_overflow_count = 0;
 
     // init isr safe fifo
     fifo_init(&telemetry_fifo_buffer, telemetry_buffer, TELEMETRY_BUFFER_LENGTH);
@@ -62,19 +122,48 @@ void telemetry_enqueue(uint8_t byte) {
     // insert into fifo
     if (!fifo_put(&telemetry_fifo_buffer, byte)) {
         // debug("telemetry: fifo full\n");
+        telemetry_overflow_count++;
     }
 }
 
+void telemetry_enqueue_block(const uint8_t *data, uint8_t len) {
+    // insert the whole hub payload of a packet at once
+    uint8_t stored = fifo_write_block(&telemetry_fifo_buffer, data, len);
+    telemetry_overflow_count += len - stored;
+}
+
 void telemetry_process(void) {
-    // handle telemetry packets
-    if (!fifo_empty(&telemetry_fifo_buffer)) {
-        uint8_t byte = fifo_get(&telemetry_fifo_buffer);
+    uint8_t buffer[16];
+    uint8_t count, i;
+
+    // drain everything that arrived since the last call
+    while ((count = fifo_read_block(&telemetry_fifo_buffer, buffer, sizeof(buffer))) != 0) {
         // process incoming telemetry
-        telemetry_parse_stream(byte);
+        for (i = 0; i < count; i++) {
+            telemetry_parse_stream(buffer[i]);
+        }
     }
 }
 
+uint32_t telemetry_get_overflow_count(void) {
+    return telemetry_overflow_count;
+}
+
 static void telemetry_parse_stream(uint8_t byte) {
+    // smartport frames start with 0x7e. inside a hub frame it is plain data
+    if ((byte == TELEMETRY_SPORT_START) &&
+        ((telemetry_state == TELEMETRY_IDLE) || (telemetry_state == TELEMETRY_DATA_ID))) {
+        telemetry_state         = TELEMETRY_IDLE;
+        telemetry_sport_active  = 1;
+        telemetry_sport_stuffed = 0;
+        telemetry_sport_index   = 0;
+        return;
+    }
+    if (telemetry_sport_active) {
+        telemetry_parse_sport(byte);
+        return;
+    }
+
     if (telemetry_state == TELEMETRY_DATA_END) {
         if (byte == 0x5e) {
             telemetry_process_hub_packet(telemetry_data_id,
@@ -122,67 +211,24 @@ static void telemetry_parse_stream(uint8_t byte) {
 static void telemetry_process_hub_packet(uint8_t id, uint16_t value) {
     // process hub data
     switch (id) {
-        // defined in protocol_sensor_hub.pdf
-        default:
-        case 0x01:  // GPS_ALT (whole number & sign) -500m-9000m (.01m/count)
-        case 0x09:  // GPS_ALT (fraction)  TODO opentx throws away the ap value and only uses bp
-        case 0x02:  // TEMP1 -30C-250C (1C/ count)
-        case 0x03:  // RPM   0-60000
-        case 0x05:  // TEMP2 -30C-250C (1C/ count)
-        case 0x06:  // Battery voltages - CELL# and VOLT
-        case 0x10:  // ALT (whole number & sign) -500m-9000m (.01m/count)
-        case 0x21:  // ALT (fraction)  (.01m/count)
-        case 0x11:  // GPS Speed (whole number and sign) in Knots
-        case 0x19:  // GPS Speed (fraction)
-        case 0x12:  // GPS Longitude (whole number) dddmm.mmmm
-        case 0x1A:  // GPS Longitude (fraction)
-        case 0x22:  // GPS Longitude E/W
-        case 0x13:  // GPS Latitude (whole number) ddmm.mmmm
-        case 0x1B:  // GPS Latitude (fraction)
-        case 0x23:  // GPS Latitude N/S
-        case 0x14:  // GPS Compass (whole number) (0-259.99) (.01degree/count)
-        case 0x1C:  // GPS Compass (fraction)
-        case 0x15:  // GPS Date/Month
-        case 0x16:  // GPS Year
-        case 0x17:  // GPS Hour/Minute
-        case 0x18:  // GPS Second
-        case 0x24:  // Accel X
-        case 0x25:  // Accel Y
-        case 0x26:  // Accel Z
-        case 0x30:  // VARIO
-            // we will ignore this data
-            break;
-
-        case 0x04:  // Fuel  0, 25, 50, 75, 100
-            // betaflight sends capacity in mah (default)
-            telemetry_decoded_data_mah =  value;
-            break;
-
-
-        case 0x28:  // Current 0A-100A (0.1A/count)
-            telemetry_decoded_data_current = value * 10;
-            /*set_telemetry(TELEM_FRSKY_CURRENT, value);
-            if (discharge_time == 0) discharge_time = CLOCK_getms();
-            discharge_dAms += (u32)value * (CLOCK_getms() - discharge_time);
-            discharge_time = CLOCK_getms();
-            set_telemetry(TELEM_FRSKY_DISCHARGE, discharge_dAms / 36000);*/
-            break;
-
-        case 0x39:  // VFAS_ID
-            telemetry_decoded_data_voltage = value * 10;
-            break;
-
         case 0x3A:  // Ampere sensor voltage (whole number) (measured as V) 0V-48V (0.5V/count)
             telemetry_last_id    = id;
             telemetry_last_value = value;
-            break;
+            return;
         case 0x3B:  // Ampere sensor voltage (fractional part)
             if (telemetry_last_id == 0x3A) {
-                telemetry_decoded_data_voltage =
-                        ((telemetry_last_value * 100 + value * 10) * 210) / 110;
+                telemetry_set_value(TELEMETRY_VALUE_VOLTAGE,
+                        ((telemetry_last_value * 100 + value * 10) * 210) / 110);
             }
+            return;
+        default:
             break;
     }
+
+    // everything else is table driven
+    telemetry_store(telemetry_find_sensor(telemetry_hub_sensors,
+                                          TELEMETRY_TABLE_SIZE(telemetry_hub_sensors), id),
+                    value);
 /*
     if (value >= VFAS_D_HIPREC_OFFSET) {
         // incoming value has a resolution of 0.01V and added offset of VFAS_D_HIPREC_OFFSET
@@ -197,14 +243,168 @@ static void telemetry_process_hub_packet(uint8_t id, uint16_t value) {
 }
 
 
+static void telemetry_parse_sport(uint8_t byte) {
+    if (byte == TELEMETRY_SPORT_STUFF) {
+        telemetry_sport_stuffed = 1;
+        return;
+    }
+    if (telemetry_sport_stuffed) {
+        byte ^= 0x20;
+        telemetry_sport_stuffed = 0;
+    }
+
+    telemetry_sport_frame[telemetry_sport_index++] = byte;
+
+    if (telemetry_sport_index == sizeof(telemetry_sport_frame)) {
+        // physical id + data frame complete, wait for the next 0x7e
+        telemetry_sport_active = 0;
+        telemetry_process_sport_frame(&telemetry_sport_frame[1]);
+    }
+}
+
+static void telemetry_process_sport_frame(const uint8_t *frame) {
+    uint16_t crc = 0;
+    uint32_t i;
+
+    // crc is 0xff - sum of all bytes with the carry added back
+    for (i = 0; i < TELEMETRY_SPORT_FRAME_LEN - 1; i++) {
+        crc += frame[i];
+        crc += crc >> 8;
+        crc &= 0xFF;
+    }
+    if ((0xFF - crc) != frame[TELEMETRY_SPORT_FRAME_LEN - 1]) {
+        return;
+    }
+
+    if (frame[0] != TELEMETRY_SPORT_DATA_FRAME) {
+        return;
+    }
+
+    uint16_t id = frame[1] | (frame[2] << 8);
+    int32_t value = (int32_t)(frame[3] | (frame[4] << 8) | (frame[5] << 16) | ((uint32_t)frame[6] << 24));
+
+    telemetry_store(telemetry_find_sensor(telemetry_sport_sensors,
+                                          TELEMETRY_TABLE_SIZE(telemetry_sport_sensors), id),
+                    value);
+}
+
+static const telemetry_sensor_t *telemetry_find_sensor(const telemetry_sensor_t *table,
+                                                       uint8_t count, uint16_t id) {
+    uint8_t lo = 0;
+    uint8_t hi = count;
+
+    // binary search over the sorted id ranges
+    while (lo < hi) {
+        uint8_t mid = (lo + hi) / 2;
+        if (id < table[mid].first) {
+            hi = mid;
+        } else if (id > table[mid].last) {
+            lo = mid + 1;
+        } else {
+            return &table[mid];
+        }
+    }
+
+    return 0;
+}
+
+static void telemetry_store(const telemetry_sensor_t *sensor, int32_t value) {
+    if (!sensor) {
+        // unknown sensor, ignore
+        return;
+    }
+
+    if (sensor->flags & TELEMETRY_SENSOR_SIGNED16) {
+        value = (int16_t)value;
+    }
+
+    telemetry_set_value(sensor->value, value * sensor->mul);
+}
+
+void telemetry_set_value(uint8_t index, int32_t value) {
+    uint32_t i;
+
+    if (index >= TELEMETRY_VALUE_COUNT) {
+        return;
+    }
+
+    uint32_t now = timeout_get_ms();
+    telemetry_value_t *sensor = &telemetry_values[index];
+
+    // called from isrs and the main loop, update the entry as a whole
+    uint32_t primask = cm_mask_interrupts(1);
+
+    if (sensor->timestamp_ms == 0) {
+        sensor->min = value;
+        sensor->max = value;
+    } else {
+        if (value < sensor->min) sensor->min = value;
+        if (value > sensor->max) sensor->max = value;
+    }
+    sensor->value = value;
+    // 0 marks a sensor that was never received
+    sensor->timestamp_ms = now ? now : 1;
+
+    for (i = 0; i < TELEMETRY_READER_COUNT; i++) {
+        telemetry_dirty[i] |= (1UL << index);
+    }
+
+    cm_mask_interrupts(primask);
+}
+
+void telemetry_get_sensor(uint8_t index, telemetry_value_t *sensor) {
+    if (index >= TELEMETRY_VALUE_COUNT) {
+        index = 0;
+    }
+
+    uint32_t primask = cm_mask_interrupts(1);
+    *sensor = telemetry_values[index];
+    cm_mask_interrupts(primask);
+}
+
+// returns the sensors that changed since the last call of this reader
+uint32_t telemetry_get_dirty(uint8_t reader) {
+    uint32_t dirty;
+
+    if (reader >= TELEMETRY_READER_COUNT) {
+        return 0;
+    }
+
+    uint32_t primask = cm_mask_interrupts(1);
+    dirty = telemetry_dirty[reader];
+    telemetry_dirty[reader] = 0;
+    cm_mask_interrupts(primask);
+
+    return dirty;
+}
+
+uint8_t telemetry_is_stale(uint8_t index) {
+    if (index >= TELEMETRY_VALUE_COUNT) {
+        return 1;
+    }
+
+    uint32_t timestamp = telemetry_values[index].timestamp_ms;
+    if (timestamp == 0) {
+        return 1;
+    }
+    return (timeout_get_ms() - timestamp) > TELEMETRY_STALE_MS;
+}
+
+int32_t telemetry_get_value(uint8_t index) {
+    if (index >= TELEMETRY_VALUE_COUNT) {
+        return 0;
+    }
+    return telemetry_values[index].value;
+}
+
 uint16_t telemetry_get_voltage(void) {
-    return telemetry_decoded_data_voltage;
+    return telemetry_values[TELEMETRY_VALUE_VOLTAGE].value;
 }
 
 uint16_t telemetry_get_current(void) {
-    return telemetry_decoded_data_current;
+    return telemetry_values[TELEMETRY_VALUE_CURRENT].value;
 }
 
 uint16_t telemetry_get_mah(void) {
-    return telemetry_decoded_data_mah;
+    return telemetry_values[TELEMETRY_VALUE_MAH].value;
 }
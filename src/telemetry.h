@@ -25,11 +25,60 @@
 
 void telemetry_init(void);
 void telemetry_enqueue(uint8_t byte);
+void telemetry_enqueue_block(const uint8_t *data, uint8_t len);
 void telemetry_process(void);
+uint32_t telemetry_get_overflow_count(void);
 
 uint16_t telemetry_get_voltage(void);
 uint16_t telemetry_get_current(void);
 uint16_t telemetry_get_mah(void);
+int32_t telemetry_get_value(uint8_t index);
+
+// decoded values, shared by hub and smartport sensors
+#define TELEMETRY_VALUE_VOLTAGE   0  // 0.01V
+#define TELEMETRY_VALUE_CURRENT   1  // 0.01A
+#define TELEMETRY_VALUE_MAH       2  // mAh drawn
+#define TELEMETRY_VALUE_RSSI      3
+#define TELEMETRY_VALUE_A1        4
+#define TELEMETRY_VALUE_A2        5
+#define TELEMETRY_VALUE_ALTITUDE  6  // cm
+#define TELEMETRY_VALUE_VARIO     7  // cm/s
+#define TELEMETRY_VALUE_TEMP1     8  // C
+#define TELEMETRY_VALUE_TEMP2     9  // C
+#define TELEMETRY_VALUE_RPM       10
+#define TELEMETRY_VALUE_LQI       11
+#define TELEMETRY_VALUE_COUNT     12
+
+// a value without update for this long is stale
+#define TELEMETRY_STALE_MS        3000
+
+// every reader gets its own dirty bitmap
+#define TELEMETRY_READER_GUI      0
+#define TELEMETRY_READER_COUNT    1
+
+typedef struct {
+    int32_t  value;
+    int32_t  min;
+    int32_t  max;
+    // time of the last update, 0 = never received
+    uint32_t timestamp_ms;
+} telemetry_value_t;
+
+void telemetry_set_value(uint8_t index, int32_t value);
+void telemetry_get_sensor(uint8_t index, telemetry_value_t *sensor);
+uint32_t telemetry_get_dirty(uint8_t reader);
+uint8_t telemetry_is_stale(uint8_t index);
+
+// sensor id range -> value store, tables are sorted by first id
+typedef struct {
+    uint16_t first;
+    uint16_t last;
+    uint8_t  value;
+    uint8_t  flags;
+    int16_t  mul;
+} telemetry_sensor_t;
+
+#define TELEMETRY_SENSOR_SIGNED16 0x01
 
 // FrSky telemetry stream state machine
 typedef enum {
@@ -41,5 +90,11 @@ typedef enum {
   TELEMETRY_XOR = 0x80  // decode stuffed byte
 } telemetry_state_t;
 
+// smartport framing: 0x7e, physical id, 8 stuffed data bytes
+#define TELEMETRY_SPORT_START      0x7E
+#define TELEMETRY_SPORT_STUFF      0x7D
+#define TELEMETRY_SPORT_DATA_FRAME 0x10
+#define TELEMETRY_SPORT_FRAME_LEN  8
+
 
 #endif  // TELEMETRY_H_
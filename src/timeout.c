@@ -30,6 +30,7 @@
 static volatile __IO uint32_t timeout_100us;
 static volatile __IO uint32_t timeout2_100us;
 static volatile __IO uint32_t timeout_100us_delay;
+static volatile __IO uint32_t timeout_100us_uptime;
 
 void timeout_init(void) {
     debug("timeout: init\n"); debug_flush();
@@ -49,6 +50,7 @@ void timeout_init(void) {
     timeout_100us = 0;
     timeout2_100us = 0;
     timeout_100us_delay = 0;
+    timeout_100us_uptime = 0;
 }
 
 void timeout_set_100us(__IO uint32_t hus) {
@@ -82,6 +84,8 @@ void timeout_delay_ms(uint32_t timeout) {
 }
 
 void sys_tick_handler(void) {
+    timeout_100us_uptime++;
+
     if (timeout_100us != 0) {
         timeout_100us--;
     }
@@ -100,3 +104,7 @@ void sys_tick_handler(void) {
 uint32_t timeout_time_remaining(void) {
     return timeout_100us/ 10;
 }
+
+uint32_t timeout_get_ms(void) {
+    return timeout_100us_uptime / 10;
+}
@@ -33,5 +33,6 @@ uint8_t timeout_timed_out(void);
 uint8_t timeout2_timed_out(void);
 void timeout_delay_ms(uint32_t timeout);
 uint32_t timeout_time_remaining(void);
+uint32_t timeout_get_ms(void);
 
 #endif  // TIMEOUT_H_
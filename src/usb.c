@@ -293,13 +293,15 @@ bool usb_enabled(void) {
 void usb_send_data(void) {
     // static uint16_t adc_data = 0;
     static uint8_t buf[1 + 16];
+    int32_t data[CHANNEL_ID_SIZE];
 
     // buttons
     buf[0] = 0;  // adc_data~(gpio_get(GPIOB, BUTTONS_PINS) >> BUTTONS_SHIFT);
 
     // sticks
+    adc_get_channels_rescaled(data);
     for (unsigned int i = 0; i < 8; i++) {
-        uint16_t res = 3200 + adc_get_channel_rescaled(i);
+        uint16_t res = 3200 + data[i];
         buf[1 + i * 2] = res & 0xff;
         buf[1 + i * 2 + 1] = res >> 8;
     }
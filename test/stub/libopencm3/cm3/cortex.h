@@ -0,0 +1,12 @@
+// host build: there are no interrupts to mask
+#ifndef TEST_STUB_CORTEX_H_
+#define TEST_STUB_CORTEX_H_
+
+#include <stdint.h>
+
+static inline uint32_t cm_mask_interrupts(uint32_t mask) {
+    (void)mask;
+    return 0;
+}
+
+#endif  // TEST_STUB_CORTEX_H_
@@ -0,0 +1,5 @@
+// host build: macros.h pulls this in, nothing of it is used
+#ifndef TEST_STUB_RCC_H_
+#define TEST_STUB_RCC_H_
+
+#endif  // TEST_STUB_RCC_H_
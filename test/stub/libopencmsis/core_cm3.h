@@ -0,0 +1,7 @@
+// host build: only the qualifiers used by the firmware headers
+#ifndef TEST_STUB_CORE_CM3_H_
+#define TEST_STUB_CORE_CM3_H_
+
+#define __IO volatile
+
+#endif  // TEST_STUB_CORE_CM3_H_
@@ -0,0 +1,214 @@
+/*
+    Copyright 2016 fishpepper <AT> gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    author: fishpepper <AT> gmail.com
+*/
+
+// host test: block fifo wraparound and a telemetry decode benchmark
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "fifo.h"
+#include "telemetry.h"
+
+#define TEST_FIFO_LENGTH    16
+#define TEST_FIFO_ROUNDS    100000
+// hub payload bytes per telemetry packet
+#define TEST_CHUNK          10
+#define TEST_STREAM_FRAMES  4096
+#define TEST_BENCH_BYTES    (64UL * 1024 * 1024)
+
+static uint32_t test_failures;
+
+// internal functions
+static void test_check(const char *name, uint32_t ok);
+static void test_fifo_wraparound(unsigned start);
+static void test_fifo_full(void);
+static uint32_t test_hub_frame(uint8_t *out, uint8_t id, uint16_t value);
+static void test_telemetry_decode(void);
+static void test_telemetry_overflow(void);
+static void test_telemetry_benchmark(void);
+
+
+int main(void) {
+    test_fifo_wraparound(0);
+    // the head and tail counters overflow as well
+    test_fifo_wraparound(UINT_MAX - 3 * TEST_FIFO_LENGTH);
+    test_fifo_full();
+    test_telemetry_decode();
+    test_telemetry_overflow();
+
+    if (test_failures) {
+        printf("fifo: %u failure(s)\n", test_failures);
+        return 1;
+    }
+
+    test_telemetry_benchmark();
+    printf("fifo: ok\n");
+    return 0;
+}
+
+static void test_check(const char *name, uint32_t ok) {
+    if (!ok) {
+        printf("FAIL: %s\n", name);
+        test_failures++;
+    }
+}
+
+static void test_fifo_wraparound(unsigned start) {
+    volatile uint8_t storage[TEST_FIFO_LENGTH];
+    fifo_buffer_t fifo;
+    uint8_t block[TEST_FIFO_LENGTH];
+    uint8_t next_write = 0, next_read = 0;
+    unsigned round, i, len, count;
+
+    fifo_init(&fifo, storage, TEST_FIFO_LENGTH);
+    fifo.head = start;
+    fifo.tail = start;
+
+    // writes and reads of changing length, the data is a running counter
+    for (round = 0; round < TEST_FIFO_ROUNDS; round++) {
+        len = 1 + (round * 7) % (TEST_FIFO_LENGTH - 1);
+        for (i = 0; i < len; i++) {
+            block[i] = next_write + i;
+        }
+        count = fifo_write_block(&fifo, block, len);
+        next_write += count;
+
+        len = 1 + (round * 5) % TEST_FIFO_LENGTH;
+        count = fifo_read_block(&fifo, block, len);
+        for (i = 0; i < count; i++) {
+            if (block[i] != next_read) {
+                printf("FAIL: fifo wraparound: round %u byte %u is %u, expected %u\n",
+                       round, i, block[i], next_read);
+                test_failures++;
+                return;
+            }
+            next_read++;
+        }
+    }
+
+    // drain the rest with single byte reads
+    while (!fifo_empty(&fifo)) {
+        if (fifo_get(&fifo) != next_read) {
+            test_check("fifo wraparound: drain", 0);
+            return;
+        }
+        next_read++;
+    }
+    test_check("fifo wraparound: all written bytes read back", next_read == next_write);
+}
+
+static void test_fifo_full(void) {
+    volatile uint8_t storage[TEST_FIFO_LENGTH];
+    fifo_buffer_t fifo;
+    uint8_t block[TEST_FIFO_LENGTH + 4] = { 0 };
+
+    fifo_init(&fifo, storage, TEST_FIFO_LENGTH);
+    test_check("fifo full: partial write", fifo_write_block(&fifo, block, 10) == 10);
+    test_check("fifo full: write is cut", fifo_write_block(&fifo, block, 10) == TEST_FIFO_LENGTH - 10);
+    test_check("fifo full: no space left", fifo_write_block(&fifo, block, 1) == 0);
+    test_check("fifo full: put fails", !fifo_put(&fifo, 1));
+    test_check("fifo full: read all", fifo_read_block(&fifo, block, sizeof(block)) == TEST_FIFO_LENGTH);
+    test_check("fifo full: empty", fifo_read_block(&fifo, block, sizeof(block)) == 0);
+}
+
+// one hub frame without the leading 0x5e, the next frame (or 0x5e) ends it
+static uint32_t test_hub_frame(uint8_t *out, uint8_t id, uint16_t value) {
+    uint8_t raw[3] = { id, value & 0xFF, value >> 8 };
+    uint32_t i, len = 0;
+
+    out[len++] = 0x5e;
+    for (i = 0; i < sizeof(raw); i++) {
+        if ((raw[i] == 0x5e) || (raw[i] == 0x5d)) {
+            out[len++] = 0x5d;
+            out[len++] = raw[i] ^ 0x60;
+        } else {
+            out[len++] = raw[i];
+        }
+    }
+    return len;
+}
+
+static void test_telemetry_decode(void) {
+    uint8_t stream[64];
+    uint32_t len = 0;
+
+    telemetry_init();
+
+    // rpm with both escaped bytes, voltage with a scale factor
+    len += test_hub_frame(&stream[len], 0x03, 0x5e5d);
+    len += test_hub_frame(&stream[len], 0x39, 123);
+    stream[len++] = 0x5e;
+
+    telemetry_enqueue_block(stream, len);
+    telemetry_process();
+
+    test_check("telemetry decode: stuffed rpm", telemetry_get_value(TELEMETRY_VALUE_RPM) == 0x5e5d);
+    test_check("telemetry decode: voltage", telemetry_get_value(TELEMETRY_VALUE_VOLTAGE) == 1230);
+    test_check("telemetry decode: no overflow", telemetry_get_overflow_count() == 0);
+}
+
+static void test_telemetry_overflow(void) {
+    uint8_t stream[100] = { 0 };
+
+    telemetry_init();
+
+    // more than the fifo holds without a telemetry_process() in between
+    telemetry_enqueue_block(stream, 50);
+    telemetry_enqueue_block(stream, 50);
+    test_check("telemetry overflow: counted", telemetry_get_overflow_count() == 100 - 64);
+
+    telemetry_process();
+    telemetry_enqueue_block(stream, 50);
+    test_check("telemetry overflow: space after drain", telemetry_get_overflow_count() == 100 - 64);
+}
+
+static void test_telemetry_benchmark(void) {
+    static uint8_t stream[TEST_STREAM_FRAMES * 7 + 1];
+    struct timespec start, end;
+    uint32_t len = 0, i, pos;
+    unsigned long total = 0;
+    double seconds;
+
+    for (i = 0; i < TEST_STREAM_FRAMES; i++) {
+        // mix of plain and escaped values over several sensors
+        len += test_hub_frame(&stream[len], (i & 1) ? 0x39 : 0x28, i * 0x1d);
+    }
+    stream[len++] = 0x5e;
+
+    telemetry_init();
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    // one hub payload per telemetry packet, drained like the main loop does
+    while (total < TEST_BENCH_BYTES) {
+        for (pos = 0; pos < len; pos += TEST_CHUNK) {
+            uint32_t chunk = (len - pos < TEST_CHUNK) ? (len - pos) : TEST_CHUNK;
+            telemetry_enqueue_block(&stream[pos], chunk);
+            telemetry_process();
+        }
+        total += len;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    test_check("telemetry benchmark: no overflow", telemetry_get_overflow_count() == 0);
+    printf("telemetry decode: %lu bytes in %.3fs, %.1f MB/s\n", total, seconds,
+           total / seconds / 1e6);
+}
@@ -0,0 +1,198 @@
+/*
+    Copyright 2016 fishpepper <AT> gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    author: fishpepper <AT> gmail.com
+*/
+
+// host test: compiled mixer results and a benchmark of the time per
+// frame against the number of mixes
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "mixer.h"
+#include "shaping.h"
+#include "storage.h"
+#include "protocol/common.h"
+
+#define TEST_BENCH_FRAMES   2000000UL
+
+// the firmware globals and services the mixer runs on
+STORAGE_DESC storage;
+s32 Channels[NUM_OUT_CHANNELS];
+static int32_t test_adc[CHANNEL_ID_SIZE];
+
+static uint32_t test_failures;
+
+// internal functions
+static void test_check(const char *name, uint32_t ok);
+static uint32_t test_near(int32_t value, int32_t expected);
+static void test_model_init(void);
+static void test_mix_set(uint8_t index, uint8_t source, uint8_t destination, int8_t weight,
+                         int8_t offset, uint8_t sw, uint8_t mode);
+static void test_mixer_outputs(void);
+static void test_mixer_benchmark(void);
+
+
+void adc_get_channels_rescaled(int32_t *data) {
+    uint32_t i;
+    for (i = 0; i < CHANNEL_ID_SIZE; i++) {
+        data[i] = test_adc[i];
+    }
+}
+
+u32 CLOCK_getus(void) {
+    return 0;
+}
+
+int main(void) {
+    test_mixer_outputs();
+
+    if (test_failures) {
+        printf("mixer: %u failure(s)\n", test_failures);
+        return 1;
+    }
+
+    test_mixer_benchmark();
+    printf("mixer: ok\n");
+    return 0;
+}
+
+static void test_check(const char *name, uint32_t ok) {
+    if (!ok) {
+        printf("FAIL: %s\n", name);
+        test_failures++;
+    }
+}
+
+// fixed point rounding, allow 0.1%
+static uint32_t test_near(int32_t value, int32_t expected) {
+    return abs(value - expected) <= CHAN_MAX_VALUE / 1000;
+}
+
+// the storage defaults: linear shaping, no mixes
+static void test_model_init(void) {
+    uint32_t i, k;
+    MODEL_DESC *model = &storage.model[0];
+
+    storage.current_model = 0;
+    model->mixer_lead = MIXER_LEAD_TIME_DEFAULT_US / MIXER_LEAD_TIME_STEP_US;
+
+    for (i = 0; i < STORAGE_SHAPING_COUNT; i++) {
+        model->shaping[i].deadband = 0;
+        model->shaping[i].expo = 0;
+        for (k = 0; k < STORAGE_CURVE_POINTS; k++) {
+            model->shaping[i].curve[k] = -100 + (k * 200) / (STORAGE_CURVE_POINTS - 1);
+        }
+    }
+
+    for (i = 0; i < STORAGE_MIX_COUNT; i++) {
+        test_mix_set(i, MIXER_SOURCE_NONE, 0, 100, 0, MIXER_SWITCH_ALWAYS, MIXER_MODE_ADD);
+    }
+}
+
+static void test_mix_set(uint8_t index, uint8_t source, uint8_t destination, int8_t weight,
+                         int8_t offset, uint8_t sw, uint8_t mode) {
+    MODEL_MIX_DESC *mix = &storage.model[0].mix[index];
+
+    mix->source = source;
+    mix->destination = destination;
+    mix->weight = weight;
+    mix->offset = offset;
+    mix->sw = sw;
+    mix->mode = mode;
+}
+
+static void test_mixer_outputs(void) {
+    uint32_t i;
+
+    // +/-ADC_RESCALED_ABSOLUTE_MAX = +/-100%
+    test_adc[CHANNEL_ID_AILERON]   =  1600;
+    test_adc[CHANNEL_ID_ELEVATION] = -800;
+    test_adc[CHANNEL_ID_THROTTLE]  =  0;
+    test_adc[CHANNEL_ID_RUDDER]    =  3200;
+    test_adc[CHANNEL_ID_CH0]       =  3200;
+    test_adc[CHANNEL_ID_CH1]       = -3200;
+    test_adc[CHANNEL_ID_CH2]       =  1600;
+    test_adc[CHANNEL_ID_CH3]       =  0;
+
+    test_model_init();
+    mixer_init();
+
+    // no mixes, every output follows its input
+    for (i = 0; i < MIXER_OUTPUT_COUNT; i++) {
+        int32_t expected = (test_adc[i] * CHAN_MAX_VALUE) / ADC_RESCALED_ABSOLUTE_MAX;
+        test_check("mixer: passthrough", test_near(Channels[i], expected));
+    }
+
+    // ail += 50% ele, thr = 100% + 20%, rud *= ch2
+    test_mix_set(0, CHANNEL_ID_ELEVATION, CHANNEL_ID_AILERON, 50, 0,
+                 MIXER_SWITCH_ALWAYS, MIXER_MODE_ADD);
+    test_mix_set(1, MIXER_SOURCE_MAX, CHANNEL_ID_THROTTLE, 100, 20,
+                 MIXER_SWITCH_ALWAYS, MIXER_MODE_REPLACE);
+    test_mix_set(2, CHANNEL_ID_CH2, CHANNEL_ID_RUDDER, 100, 0,
+                 MIXER_SWITCH_ALWAYS, MIXER_MODE_MULTIPLY);
+    // only while ch0 is low, ch0 is high here
+    test_mix_set(3, MIXER_SOURCE_MAX, CHANNEL_ID_CH3, 100, 0,
+                 MIXER_SWITCH_LOW(0), MIXER_MODE_REPLACE);
+    // invalid destinations are dropped by the compiler
+    test_mix_set(4, MIXER_SOURCE_MAX, MIXER_OUTPUT_COUNT, 100, 0,
+                 MIXER_SWITCH_ALWAYS, MIXER_MODE_REPLACE);
+    mixer_compile();
+    mixer_process();
+
+    test_check("mixer: add", test_near(Channels[CHANNEL_ID_AILERON], 5000 - 1250));
+    test_check("mixer: replace clamps", test_near(Channels[CHANNEL_ID_THROTTLE], CHAN_MAX_VALUE));
+    test_check("mixer: multiply", test_near(Channels[CHANNEL_ID_RUDDER], 5000));
+    test_check("mixer: switch", test_near(Channels[CHANNEL_ID_CH3], 0));
+
+    // the switch position flips the mix on
+    test_adc[CHANNEL_ID_CH0] = -3200;
+    mixer_process();
+    test_check("mixer: switch low", test_near(Channels[CHANNEL_ID_CH3], CHAN_MAX_VALUE));
+}
+
+static void test_mixer_benchmark(void) {
+    struct timespec start, end;
+    uint32_t count, i;
+    unsigned long frame;
+    double seconds;
+
+    test_model_init();
+    mixer_init();
+
+    for (count = 0; count <= STORAGE_MIX_COUNT; count++) {
+        // worst case: every mix is active and does a clamped multiply
+        for (i = 0; i < count; i++) {
+            test_mix_set(i, i % MIXER_SOURCE_COUNT, (i * 3) % MIXER_OUTPUT_COUNT, 80, 10,
+                         MIXER_SWITCH_ALWAYS, (i & 1) ? MIXER_MODE_MULTIPLY : MIXER_MODE_ADD);
+        }
+        mixer_compile();
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (frame = 0; frame < TEST_BENCH_FRAMES; frame++) {
+            // keep the inputs moving so nothing is hoisted out of the loop
+            test_adc[CHANNEL_ID_AILERON] = (frame & 0x1FFF) - 3200;
+            mixer_process();
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+        printf("mixer: %u mixes, %.3f us per frame\n", count,
+               seconds * 1e6 / TEST_BENCH_FRAMES);
+    }
+}
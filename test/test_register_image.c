@@ -0,0 +1,228 @@
+/*
+    Copyright 2016 fishpepper <AT> gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    author: fishpepper <AT> gmail.com
+*/
+
+// host test: expands the const register images and compares them
+// against the sparse per-register tables they replaced
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "register_image.h"
+
+typedef uint8_t u8;
+
+// cc2500 register addresses and the images, taken from the sources
+#include "images.inc"
+
+#define REGISTER_COUNT 0x40
+
+// one (address, value) pair per register write
+typedef struct {
+    uint8_t address;
+    uint8_t value;
+} write_t;
+
+static uint32_t test_failures;
+
+// cc2500 config register reset values, see the datasheet
+static const uint8_t cc2500_reset_values[TEST0 + 1] = {
+    0x29, 0x2E, 0x3F, 0x07, 0xD3, 0x91, 0xFF, 0x04, 0x45, 0x00, 0x00, 0x0F, 0x00, 0x5E, 0xC4, 0xEC,
+    0x8C, 0x22, 0x02, 0x22, 0xF8, 0x47, 0x07, 0x30, 0x04, 0x36, 0x6C, 0x03, 0x40, 0x91, 0x87, 0x6B,
+    0xF8, 0x56, 0x10, 0xA9, 0x0A, 0x20, 0x0D, 0x41, 0x00, 0x59, 0x7F, 0x3F, 0x88, 0x31, 0x0B
+};
+
+// d8 setup as single register writes, FSCTRL0 holds the frequency offset
+static const write_t frsky_writes[] = {
+    { MCSM1,    0x0C }, { MCSM0,    0x18 }, { PKTLEN,   0x19 }, { PKTCTRL1, 0x04 },
+    { PKTCTRL0, 0x05 }, { PA_TABLE0, 0xFF }, { FSCTRL1,  0x08 }, { FSCTRL0,  0x00 },
+    { FREQ2,    0x5C }, { FREQ1,    0x76 }, { FREQ0,    0x27 }, { MDMCFG4,  0xAA },
+    { MDMCFG3,  0x39 }, { MDMCFG2,  0x11 }, { MDMCFG1,  0x23 }, { MDMCFG0,  0x7A },
+    { DEVIATN,  0x42 }, { FOCCFG,   0x16 }, { BSCFG,    0x6C }, { AGCCTRL2, 0x03 },
+    { AGCCTRL1, 0x40 }, { AGCCTRL0, 0x91 }, { FREND1,   0x56 }, { FREND0,   0x10 },
+    { FSCAL3,   0xA9 }, { FSCAL2,   0x0A }, { FSCAL1,   0x00 }, { FSCAL0,   0x11 },
+    { FSTEST,   0x59 }, { TEST2,    0x88 }, { TEST1,    0x31 }, { TEST0,    0x0B },
+    { FIFOTHR,  0x07 }, { ADDR,     0x00 }
+};
+
+// flysky: 0xFF entries are skipped
+static const u8 flysky_sparse[] = {
+    0xFF, 0x42, 0x00, 0x14, 0x00, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x01, 0x21, 0x05, 0x00, 0x50,
+    0x9e, 0x4b, 0x00, 0x02, 0x16, 0x2b, 0x12, 0x00, 0x62, 0x80, 0x80, 0x00, 0x0a, 0x32, 0xc3, 0x0f,
+    0x13, 0xc3, 0x00, 0xFF, 0x00, 0x00, 0x3b, 0x00, 0x17, 0x47, 0x80, 0x03, 0x01, 0x45, 0x18, 0x00,
+    0x01, 0x0f, 0xFF,
+};
+
+// afhds2a and joysway: -1 entries are skipped
+static const u8 afhds2a_sparse[] = {
+    -1  , 0x42 | (1<<5), 0x00, 0x25, 0x00,   -1,   -1, 0x00, 0x00, 0x00, 0x00, 0x01, 0x3c, 0x05, 0x00, 0x50, // 00 - 0f
+    0x9e, 0x4b, 0x00, 0x02, 0x16, 0x2b, 0x12, 0x4f, 0x62, 0x80,   -1,   -1, 0x2a, 0x32, 0xc3, 0x1f, // 10 - 1f
+    0x1e,   -1, 0x00,   -1, 0x00, 0x00, 0x3b, 0x00, 0x17, 0x47, 0x80, 0x03, 0x01, 0x45, 0x18, 0x00, // 20 - 2f
+    0x01, 0x0f // 30 - 31
+};
+
+static const u8 joysway_sparse[] = {
+    0x00, 0x62,   -1, 0x0f, 0x00,  -1 ,  -1 , 0x00,     0x00, 0x05, 0x00, 0x01, 0x00, 0xf5, 0x00, 0x15,
+    0x9e, 0x4b, 0x00, 0x03, 0x56, 0x2b, 0x12, 0x4a,     0x02, 0x80, 0x80, 0x00, 0x0e, 0x91, 0x03, 0x0f,
+    0x16, 0x2a, 0x00,  -1,    -1,   -1, 0x3a, 0x06,     0x1f, 0x47, 0x80, 0x01, 0x05, 0x45, 0x18, 0x00,
+    0x01, 0x0f, 0x00
+};
+
+// internal functions
+static uint32_t test_expand_image(const uint8_t *image, write_t *writes);
+static uint32_t test_expand_sparse(const u8 *table, uint32_t len, u8 skip, write_t *writes);
+static void test_compare_writes(const char *name, const write_t *expected, uint32_t expected_count,
+                                const write_t *actual, uint32_t actual_count);
+static void test_check(const char *name, uint32_t ok);
+static void test_cc2500_runs(void);
+static void test_cc2500_state(void);
+static void test_a7105(const char *name, const uint8_t *image, const u8 *table, uint32_t len, u8 skip);
+
+
+int main(void) {
+    test_cc2500_runs();
+    test_cc2500_state();
+
+    test_a7105("flysky", flysky_register_image, flysky_sparse, sizeof(flysky_sparse), 0xFF);
+    test_a7105("afhds2a", afhds2a_register_image, afhds2a_sparse, sizeof(afhds2a_sparse), (u8)-1);
+    test_a7105("joysway", joysway_register_image, joysway_sparse, sizeof(joysway_sparse), (u8)-1);
+
+    if (test_failures) {
+        printf("register image: %u failure(s)\n", test_failures);
+        return 1;
+    }
+    printf("register image: ok\n");
+    return 0;
+}
+
+static uint32_t test_expand_image(const uint8_t *image, write_t *writes) {
+    uint32_t count = 0;
+
+    // the same walk as cc2500_write_register_image() and A7105_WriteRegisterImage()
+    while (REGISTER_IMAGE_RUN_LENGTH(image)) {
+        uint8_t i;
+        for (i = 0; i < REGISTER_IMAGE_RUN_LENGTH(image); i++) {
+            writes[count].address = REGISTER_IMAGE_RUN_ADDRESS(image) + i;
+            writes[count].value   = REGISTER_IMAGE_RUN_DATA(image)[i];
+            count++;
+        }
+        image = REGISTER_IMAGE_NEXT_RUN(image);
+    }
+    return count;
+}
+
+static uint32_t test_expand_sparse(const u8 *table, uint32_t len, u8 skip, write_t *writes) {
+    uint32_t count = 0;
+    uint32_t i;
+
+    for (i = 0; i < len; i++) {
+        if (table[i] != skip) {
+            writes[count].address = i;
+            writes[count].value   = table[i];
+            count++;
+        }
+    }
+    return count;
+}
+
+static void test_check(const char *name, uint32_t ok) {
+    if (!ok) {
+        printf("FAIL: %s\n", name);
+        test_failures++;
+    }
+}
+
+static void test_compare_writes(const char *name, const write_t *expected, uint32_t expected_count,
+                                const write_t *actual, uint32_t actual_count) {
+    uint32_t i;
+
+    if (expected_count != actual_count) {
+        printf("FAIL: %s: %u writes, expected %u\n", name, actual_count, expected_count);
+        test_failures++;
+        return;
+    }
+    for (i = 0; i < expected_count; i++) {
+        if ((expected[i].address != actual[i].address) || (expected[i].value != actual[i].value)) {
+            printf("FAIL: %s: write %u is [0x%02X] = 0x%02X, expected [0x%02X] = 0x%02X\n", name, i,
+                   actual[i].address, actual[i].value, expected[i].address, expected[i].value);
+            test_failures++;
+            return;
+        }
+    }
+}
+
+static void test_cc2500_runs(void) {
+    // each run is one burst, the chip auto increments the address.
+    // runs have to be ascending and must not cross into the status registers
+    const uint8_t *image = frsky_register_image;
+    int32_t next = 0;
+
+    while (REGISTER_IMAGE_RUN_LENGTH(image)) {
+        uint8_t address = REGISTER_IMAGE_RUN_ADDRESS(image);
+        uint8_t len     = REGISTER_IMAGE_RUN_LENGTH(image);
+
+        test_check("frsky: runs ascending and not overlapping", address >= next);
+        test_check("frsky: run within the config registers or the pa table",
+                   ((address + len) <= (TEST0 + 1)) || ((address == PA_TABLE0) && (len == 1)));
+
+        next  = address + len;
+        image = REGISTER_IMAGE_NEXT_RUN(image);
+    }
+}
+
+static void test_cc2500_state(void) {
+    // the image writes some extra registers with their reset value,
+    // thus compare the resulting register file of both sequences
+    uint8_t regs_image[REGISTER_COUNT];
+    uint8_t regs_single[REGISTER_COUNT];
+    write_t writes[REGISTER_COUNT];
+    uint32_t count, i;
+
+    memset(regs_image, 0, sizeof(regs_image));
+    memcpy(regs_image, cc2500_reset_values, sizeof(cc2500_reset_values));
+    memcpy(regs_single, regs_image, sizeof(regs_image));
+
+    count = test_expand_image(frsky_register_image, writes);
+    for (i = 0; i < count; i++) {
+        regs_image[writes[i].address] = writes[i].value;
+    }
+    // FSCTRL0 is written on its own after the image
+    regs_image[FSCTRL0] = 0x00;
+
+    for (i = 0; i < sizeof(frsky_writes) / sizeof(frsky_writes[0]); i++) {
+        regs_single[frsky_writes[i].address] = frsky_writes[i].value;
+    }
+
+    for (i = 0; i < REGISTER_COUNT; i++) {
+        if (regs_image[i] != regs_single[i]) {
+            printf("FAIL: frsky: register 0x%02X is 0x%02X, expected 0x%02X\n", i, regs_image[i], regs_single[i]);
+            test_failures++;
+        }
+    }
+}
+
+static void test_a7105(const char *name, const uint8_t *image, const u8 *table, uint32_t len, u8 skip) {
+    // a7105 control registers do not auto increment, the image is sent
+    // as one frame per register and has to match the old loop exactly
+    write_t expected[REGISTER_COUNT];
+    write_t actual[REGISTER_COUNT];
+    uint32_t expected_count = test_expand_sparse(table, len, skip, expected);
+    uint32_t actual_count   = test_expand_image(image, actual);
+
+    test_compare_writes(name, expected, expected_count, actual, actual_count);
+}
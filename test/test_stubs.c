@@ -0,0 +1,37 @@
+/*
+    Copyright 2016 fishpepper <AT> gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    author: fishpepper <AT> gmail.com
+*/
+
+// host builds: the firmware services the tested modules link against
+#include <stdint.h>
+#include "debug.h"
+#include "timeout.h"
+
+static uint32_t test_stub_ms;
+
+void debug(char *data) { (void)data; }
+void debug_flush(void) { }
+void debug_put_hex8(uint8_t val) { (void)val; }
+void debug_put_uint8(uint8_t c) { (void)c; }
+void debug_put_uint16(uint16_t c) { (void)c; }
+void debug_put_newline(void) { }
+
+// every call advances the time by one millisecond
+uint32_t timeout_get_ms(void) {
+    return ++test_stub_ms;
+}